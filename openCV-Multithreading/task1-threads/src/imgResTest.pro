@@ -8,11 +8,13 @@ QMAKE_CXXFLAGS +=-g -Wall -Wextra -Wpedantic -std=c++14 -pthread
 SOURCES += \
     imgResizeThreads.cpp \
     imgResizeMain.cpp \
-    imgResizeAsync.cpp
+    imgResizeAsync.cpp \
+    imgResizeEngine.cpp
 
 HEADERS += \
     imgResizeThreads.h \
     imgResizeAsync.h \
+    imgResizeEngine.h \
     exectimerclass.h
 
 LIBS += \
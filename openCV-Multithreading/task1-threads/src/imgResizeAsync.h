@@ -11,17 +11,23 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "imgResizeEngine.h"
+
 /**
  * @brief imageResizeAsync Resizes images asynchronously using specified
- * number of async tasks/treads (using std::async and std::future)
+ * number of async tasks/treads (using std::async and std::future),
+ * tasks resize bands of ResizeEngine, the result doesn't depend on
+ * their number
  * @param inImg Initial image to resize.
  * @param outImg Resized image to output.
  * @param outSize Size to which initial image should be resized.
  * @param taskNum Number of async tasks/threads to use.
+ * @param filter Resampling filter.
  */
 void imageResizeAsync(const cv::Mat& inImg,
                      cv::Mat& outImg,
                      const cv::Size& outSize,
-                     int taskNum);
+                     int taskNum,
+                     ResizeFilter filter=ResizeFilter::Bilinear);
 
 # endif // IMG_RESIZE_ASYNC_H
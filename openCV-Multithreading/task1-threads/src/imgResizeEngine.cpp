@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "imgResizeEngine.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IMG_RESIZE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using Axis=ResizeEngine::Axis;
+
+const double pi=3.14159265358979323846;
+
+double sinc(double x){
+    if (x==0)
+        return 1;
+    x*=pi;
+    return std::sin(x)/x;
+}
+
+// weight of a source pixel at distance x (in stretched source pixels)
+// from the center of the output one
+double filterValue(ResizeFilter filter, double x){
+    x=std::fabs(x);
+    if (filter==ResizeFilter::Lanczos)
+        return x<3 ? sinc(x)*sinc(x/3) : 0;
+    return x<1 ? 1-x : 0;
+}
+
+// normalized weights of the source pixels [lo, lo+weights.size()) of
+// output pixel d, window ends of zero weight are dropped
+void pixelWeights(int inSize, double scale, ResizeFilter filter, int d,
+                  int& lo, std::vector<double>& weights){
+    int hi;
+    weights.clear();
+    if (filter==ResizeFilter::Area){
+        // parts of the source pixels covered by the output one
+        double beg=d*scale, end=(d+1)*scale;
+        lo=int(beg);
+        hi=std::min(int(std::ceil(end)), inSize);
+        for (int x=lo; x<hi; ++x)
+            weights.push_back(std::min(x+1.0, end)-std::max(double(x), beg));
+    } else {
+        // Lanczos is stretched over the covered pixels when downscaling,
+        // bilinear keeps two taps as cv::resize does
+        double stretch=filter==ResizeFilter::Lanczos ? std::max(scale, 1.0)
+                                                     : 1.0;
+        double radius=(filter==ResizeFilter::Lanczos ? 3 : 1)*stretch;
+        double center=(d+0.5)*scale;
+        lo=std::max(int(std::floor(center-radius-0.5)), 0);
+        hi=std::min(int(std::ceil(center+radius-0.5))+1, inSize);
+        for (int x=lo; x<hi; ++x)
+            weights.push_back(filterValue(filter, (x+0.5-center)/stretch));
+    }
+    while (!weights.empty() && weights.back()==0)
+        weights.pop_back();
+    while (!weights.empty() && weights.front()==0){
+        weights.erase(weights.begin());
+        ++lo;
+    }
+    double sum=0;
+    for (double w: weights)
+        sum+=w;
+    for (double& w: weights)
+        w/=sum;
+}
+
+// coefficients of outSize pixels resized from inSize ones, taps are
+// padded with zeros to a multiple of tapsStep. Fixed point weights of
+// a pixel sum to mCoefScale exactly, so flat areas stay flat.
+void fillAxis(int inSize, int outSize, ResizeFilter filter, int tapsStep,
+              Axis& axis){
+    double scale=(double)inSize/outSize;
+    std::vector<double> weights;
+    int lo, taps=1;
+    for (int d=0; d<outSize; ++d){
+        pixelWeights(inSize, scale, filter, d, lo, weights);
+        taps=std::max(taps, int(weights.size()));
+    }
+    axis.mTaps=(taps+tapsStep-1)/tapsStep*tapsStep;
+    axis.mBegin.resize(outSize);
+    axis.mFixed.assign(outSize*axis.mTaps, 0);
+    axis.mWeights.assign(outSize*axis.mTaps, 0);
+    for (int d=0; d<outSize; ++d){
+        pixelWeights(inSize, scale, filter, d, lo, weights);
+        // windows at the right edge are shifted to stay in the image
+        int begin=std::min(lo, inSize-taps);
+        axis.mBegin[d]=begin;
+        short* fixed=&axis.mFixed[d*axis.mTaps+lo-begin];
+        double* frac=&axis.mWeights[d*axis.mTaps+lo-begin];
+        int total=0, maxInd=0;
+        for (int t=0; t<int(weights.size()); ++t){
+            frac[t]=weights[t];
+            fixed[t]=short(cvRound(weights[t]*ResizeEngine::mCoefScale));
+            total+=fixed[t];
+            if (std::fabs(weights[t])>std::fabs(weights[maxInd]))
+                maxInd=t;
+        }
+        fixed[maxInd]+=ResizeEngine::mCoefScale-total;
+    }
+}
+
+// steps of taps of the horizontal kernels
+int tapsStepOf(int channels){
+    return channels==1 ? 8 : 2;
+}
+
+// elements after a row between the passes, zero padded taps read them
+int interPadOf(int channels){
+    return 8*channels+8;
+}
+
+// elements of a row block of the vertical pass: its accumulators stay
+// in L1 while the source rows of all taps are added to them
+const int blockSize=2048;
+
+// 8-bit images: the vertical pass keeps mInterBits fractional bits,
+// the horizontal one rounds them off
+const int verticalShift=ResizeEngine::mCoefBits-ResizeEngine::mInterBits;
+const int horizontalShift=ResizeEngine::mCoefBits+ResizeEngine::mInterBits;
+
+typedef void (*VerticalPass)(const uchar* const* rows, const short* weights,
+                             int taps, int width, int* acc, short* dst);
+typedef void (*HorizontalPass)(const short* src, const Axis& axis,
+                               int channels, uchar* dst);
+
+void verticalScalar(const uchar* const* rows, const short* weights,
+                    int taps, int width, int* acc, short* dst){
+    for (int blk=0; blk<width; blk+=blockSize){
+        int num=std::min(blockSize, width-blk);
+        std::fill(acc, acc+num, 0);
+        for (int t=0; t<taps; ++t){
+            const uchar* src=rows[t]+blk;
+            int w=weights[t];
+            for (int k=0; k<num; ++k)
+                acc[k]+=src[k]*w;
+        }
+        for (int k=0; k<num; ++k)
+            dst[blk+k]=short((acc[k]+(1<<(verticalShift-1)))>>verticalShift);
+    }
+}
+
+inline uchar castFixed(int val){
+    val=(val+(1<<(horizontalShift-1)))>>horizontalShift;
+    return uchar(std::min(std::max(val, 0), 255));
+}
+
+void horizontalScalar(const short* src, const Axis& axis, int channels,
+                      uchar* dst){
+    int width=int(axis.mBegin.size()), taps=axis.mTaps;
+    for (int d=0; d<width; ++d){
+        const short* from=src+axis.mBegin[d]*channels;
+        const short* w=&axis.mFixed[d*taps];
+        for (int c=0; c<channels; ++c){
+            int acc=0;
+            for (int t=0; t<taps; ++t)
+                acc+=from[t*channels+c]*w[t];
+            dst[d*channels+c]=castFixed(acc);
+        }
+    }
+}
+
+#ifdef IMG_RESIZE_X86
+// two 16-bit weights for _madd_epi16 of interleaved pairs
+inline int weightPair(short w0, short w1){
+    return int(unsigned(std::uint16_t(w1))<<16 | std::uint16_t(w0));
+}
+
+// sums of 16 elements of two rows are kept in acc in the order of
+// _unpacklo/hi_epi16 (0-3, 8-11, 4-7, 12-15), _packs_epi32 restores it;
+// the tail of a block is scalar. Integer sums are exact, so the result
+// is the same as the scalar one.
+__attribute__((target("avx2")))
+void verticalAvx2(const uchar* const* rows, const short* weights,
+                  int taps, int width, int* acc, short* dst){
+    const __m256i round=_mm256_set1_epi32(1<<(verticalShift-1));
+    for (int blk=0; blk<width; blk+=blockSize){
+        int num=std::min(blockSize, width-blk), vecNum=num&~15;
+        std::fill(acc, acc+num, 0);
+        for (int t=0; t<taps; t+=2){
+            // an odd last tap is paired with itself of weight 0
+            bool isPair=t+1<taps;
+            const uchar* src0=rows[t]+blk;
+            const uchar* src1=isPair ? rows[t+1]+blk : src0;
+            short w0=weights[t], w1=isPair ? weights[t+1] : 0;
+            __m256i w=_mm256_set1_epi32(weightPair(w0, w1));
+            int k=0;
+            for (; k<vecNum; k+=16){
+                __m256i a=_mm256_cvtepu8_epi16(
+                            _mm_loadu_si128((const __m128i*)(src0+k)));
+                __m256i b=_mm256_cvtepu8_epi16(
+                            _mm_loadu_si128((const __m128i*)(src1+k)));
+                __m256i* sums=(__m256i*)(acc+k);
+                _mm256_storeu_si256(sums, _mm256_add_epi32(
+                        _mm256_loadu_si256(sums),
+                        _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w)));
+                _mm256_storeu_si256(sums+1, _mm256_add_epi32(
+                        _mm256_loadu_si256(sums+1),
+                        _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w)));
+            }
+            for (; k<num; ++k)
+                acc[k]+=src0[k]*w0+src1[k]*w1;
+        }
+        int k=0;
+        for (; k<vecNum; k+=16){
+            const __m256i* sums=(const __m256i*)(acc+k);
+            __m256i lo=_mm256_srai_epi32(_mm256_add_epi32(
+                            _mm256_loadu_si256(sums), round), verticalShift);
+            __m256i hi=_mm256_srai_epi32(_mm256_add_epi32(
+                            _mm256_loadu_si256(sums+1), round), verticalShift);
+            _mm256_storeu_si256((__m256i*)(dst+blk+k),
+                                _mm256_packs_epi32(lo, hi));
+        }
+        for (; k<num; ++k)
+            dst[blk+k]=short((acc[k]+(1<<(verticalShift-1)))>>verticalShift);
+    }
+}
+
+// pixels of 3 and 4 channels: two taps are shuffled into channel pairs
+// for _madd_epi16, a channel per 32-bit sum; 1 channel: 8 taps at once
+__attribute__((target("avx2")))
+void horizontalAvx2(const short* src, const Axis& axis, int channels,
+                    uchar* dst){
+    if (channels!=1 && channels!=3 && channels!=4){
+        horizontalScalar(src, axis, channels, dst);
+        return;
+    }
+    int width=int(axis.mBegin.size()), taps=axis.mTaps;
+    const __m128i round=_mm_set1_epi32(1<<(horizontalShift-1));
+    const __m128i pairs3=_mm_setr_epi8(0, 1, 6, 7, 2, 3, 8, 9, 4, 5, 10, 11,
+                                       -1, -1, -1, -1);
+    const __m128i pairs4=_mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13,
+                                       6, 7, 14, 15);
+    for (int d=0; d<width; ++d){
+        const short* from=src+axis.mBegin[d]*channels;
+        const short* w=&axis.mFixed[d*taps];
+        __m128i sum=_mm_setzero_si128();
+        if (channels==1){
+            for (int t=0; t<taps; t+=8)
+                sum=_mm_add_epi32(sum, _mm_madd_epi16(
+                        _mm_loadu_si128((const __m128i*)(from+t)),
+                        _mm_loadu_si128((const __m128i*)(w+t))));
+            sum=_mm_hadd_epi32(sum, sum);
+            sum=_mm_hadd_epi32(sum, sum);
+            dst[d]=castFixed(_mm_cvtsi128_si32(sum));
+            continue;
+        }
+        const __m128i& pairs=channels==3 ? pairs3 : pairs4;
+        for (int t=0; t<taps; t+=2){
+            __m128i px=_mm_shuffle_epi8(
+                        _mm_loadu_si128((const __m128i*)(from+t*channels)),
+                        pairs);
+            sum=_mm_add_epi32(sum, _mm_madd_epi16(
+                        px, _mm_set1_epi32(weightPair(w[t], w[t+1]))));
+        }
+        sum=_mm_srai_epi32(_mm_add_epi32(sum, round), horizontalShift);
+        sum=_mm_packus_epi16(_mm_packs_epi32(sum, sum), sum);
+        int res=_mm_cvtsi128_si32(sum);
+        std::memcpy(dst+d*channels, &res, channels);
+    }
+}
+#endif
+
+struct ResizeKernels{
+    VerticalPass mVertical;
+    HorizontalPass mHorizontal;
+    const char* mIsa;
+};
+
+const ResizeKernels scalarKernels={verticalScalar, horizontalScalar,
+                                   "scalar"};
+
+struct KernelsDispatch{
+    KernelsDispatch(){
+        mBest=scalarKernels;
+#ifdef IMG_RESIZE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            mBest={verticalAvx2, horizontalAvx2, "avx2"};
+#endif
+    }
+    ResizeKernels mBest;
+};
+
+std::atomic_bool isSimdEnabled(true);
+
+const ResizeKernels& kernels(){
+    static const KernelsDispatch disp;
+    return isSimdEnabled ? disp.mBest : scalarKernels;
+}
+
+void resizeBand8U(const cv::Mat& inImg, cv::Mat& outImg, const Axis& xAxis,
+                  const Axis& yAxis, int rowBeg, int rowEnd){
+    const ResizeKernels& kern=kernels();
+    int channels=inImg.channels(), width=inImg.cols*channels;
+    std::vector<short> inter(width+interPadOf(channels));
+    std::vector<int> acc(blockSize);
+    std::vector<const uchar*> rows(yAxis.mTaps);
+    for (int dy=rowBeg; dy<rowEnd; ++dy){
+        int sy=yAxis.mBegin[dy];
+        for (int t=0; t<yAxis.mTaps; ++t)
+            rows[t]=inImg.ptr<uchar>(sy+t);
+        kern.mVertical(rows.data(), &yAxis.mFixed[dy*yAxis.mTaps],
+                       yAxis.mTaps, width, acc.data(), inter.data());
+        kern.mHorizontal(inter.data(), xAxis, channels, outImg.ptr<uchar>(dy));
+    }
+}
+
+/**
+ * @brief resizeBand Output rows [rowBeg, rowEnd) of 16-bit and floating
+ * point images: the vertical pass in blocks of row elements to a buffer,
+ * then the horizontal one from it.
+ */
+template <typename T, typename WT>
+void resizeBand(const cv::Mat& inImg, cv::Mat& outImg, const Axis& xAxis,
+                const Axis& yAxis, int rowBeg, int rowEnd){
+    int channels=inImg.channels(), width=inImg.cols*channels;
+    int outWidth=int(xAxis.mBegin.size()), xTaps=xAxis.mTaps;
+    std::vector<WT> inter(width+interPadOf(channels));
+    for (int dy=rowBeg; dy<rowEnd; ++dy){
+        int sy=yAxis.mBegin[dy];
+        const double* yWeights=&yAxis.mWeights[dy*yAxis.mTaps];
+        for (int blk=0; blk<width; blk+=blockSize){
+            int num=std::min(blockSize, width-blk);
+            WT* acc=inter.data()+blk;
+            std::fill(acc, acc+num, WT(0));
+            for (int t=0; t<yAxis.mTaps; ++t){
+                const T* src=inImg.ptr<T>(sy+t)+blk;
+                WT w=WT(yWeights[t]);
+                for (int k=0; k<num; ++k)
+                    acc[k]+=WT(src[k])*w;
+            }
+        }
+        T* dst=outImg.ptr<T>(dy);
+        for (int d=0; d<outWidth; ++d){
+            const WT* from=inter.data()+xAxis.mBegin[d]*channels;
+            const double* w=&xAxis.mWeights[d*xTaps];
+            for (int c=0; c<channels; ++c){
+                WT val=0;
+                for (int t=0; t<xTaps; ++t)
+                    val+=from[t*channels+c]*WT(w[t]);
+                dst[d*channels+c]=cv::saturate_cast<T>(val);
+            }
+        }
+    }
+}
+
+} // namespace
+
+ResizeEngine::ResizeEngine(const cv::Mat& inImg, cv::Mat& outImg,
+                           const cv::Size& outSize, ResizeFilter filter)
+    : mInImg(inImg) // keeps the source if outImg is the same image
+{
+    CV_Assert(!inImg.empty() && outSize.width>0 && outSize.height>0);
+    int depth=inImg.depth();
+    CV_Assert(depth==CV_8U || depth==CV_16U || depth==CV_16S ||
+              depth==CV_32F || depth==CV_64F);
+    outImg.create(outSize, inImg.type());
+    mOutImg=outImg;
+    fillAxis(inImg.cols, outSize.width, filter, tapsStepOf(inImg.channels()),
+             mX);
+    fillAxis(inImg.rows, outSize.height, filter, 1, mY);
+}
+
+void ResizeEngine::resizeRows(int rowBeg, int rowEnd) const {
+    if (rowBeg>=rowEnd)
+        return;
+    cv::Mat outImg=mOutImg;
+    switch (mInImg.depth()){
+    case CV_8U:
+        resizeBand8U(mInImg, outImg, mX, mY, rowBeg, rowEnd);
+        break;
+    case CV_16U:
+        resizeBand<ushort, float>(mInImg, outImg, mX, mY, rowBeg, rowEnd);
+        break;
+    case CV_16S:
+        resizeBand<short, float>(mInImg, outImg, mX, mY, rowBeg, rowEnd);
+        break;
+    case CV_32F:
+        resizeBand<float, float>(mInImg, outImg, mX, mY, rowBeg, rowEnd);
+        break;
+    default:
+        resizeBand<double, double>(mInImg, outImg, mX, mY, rowBeg, rowEnd);
+    }
+}
+
+const char* ResizeEngine::isa(){
+    return kernels().mIsa;
+}
+
+void ResizeEngine::setSimd(bool isEnabled){
+    isSimdEnabled=isEnabled;
+}
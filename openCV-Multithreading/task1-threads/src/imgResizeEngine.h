@@ -0,0 +1,83 @@
+/**
+ * @brief Resize engine which splits the output image into bands of rows
+ * for any number of threads or tasks without seams.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ *
+ */
+
+#ifndef IMG_RESIZE_ENGINE_H
+#define IMG_RESIZE_ENGINE_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief The ResizeFilter enum Area averages the source pixels covered
+ * by an output one (as cv::INTER_AREA when downscaling), Bilinear takes
+ * two of them (as cv::INTER_LINEAR), Lanczos is Lanczos3 stretched over
+ * the covered pixels when downscaling, so it doesn't alias on thumbnails.
+ */
+enum class ResizeFilter {Area, Bilinear, Lanczos};
+
+/**
+ * @brief The ResizeEngine class Separable resize (pixel centers are
+ * aligned, as in cv::resize) with filter coefficients computed once for
+ * the whole image. An output row is the vertical pass over the source
+ * rows of its filter window followed by the horizontal pass of the
+ * result, so a band of rows reads its exact source window and every
+ * pixel is computed from the same global coefficients whichever band it
+ * is in: the result is bit-identical for any split of rows.
+ * 8-bit images are computed with 14-bit fixed point weights (AVX2
+ * kernels for 1, 3 and 4 channels when the CPU has it, with the same
+ * result as the scalar ones), 16-bit and float ones in float, double
+ * ones in double.
+ */
+class ResizeEngine
+{
+public:
+    // outImg gets allocated for outSize, it must not be reallocated
+    // while bands are resized
+    ResizeEngine(const cv::Mat& inImg, cv::Mat& outImg,
+                 const cv::Size& outSize,
+                 ResizeFilter filter=ResizeFilter::Bilinear);
+    ResizeEngine(const ResizeEngine& re)=delete;
+    ResizeEngine& operator=(const ResizeEngine& re)=delete;
+    int rows() const {return mOutImg.rows;}
+    // first row of band ind of bandsNum equal ones
+    int bandBegin(int ind, int bandsNum) const {
+        return int((long long)rows()*ind/bandsNum);
+    }
+    /**
+     * @brief resizeRows Computes output rows [rowBeg, rowEnd) from
+     * source rows [sourceBegin(rowBeg), sourceEnd(rowEnd)), may be called
+     * for different bands concurrently.
+     */
+    void resizeRows(int rowBeg, int rowEnd) const;
+    int sourceBegin(int rowBeg) const {return mY.mBegin[rowBeg];}
+    int sourceEnd(int rowEnd) const {return mY.mBegin[rowEnd-1]+mY.mTaps;}
+
+    // instruction set of the 8-bit kernels: "avx2" or "scalar"
+    static const char* isa();
+    // false makes all engines use the scalar kernels (for benchmarks)
+    static void setSimd(bool isEnabled);
+
+    static const int mCoefBits=14, mCoefScale=1<<mCoefBits;
+    // fractional bits of 8-bit values between the passes
+    static const int mInterBits=6;
+    // filter coefficients of output pixels along one axis: mTaps weights
+    // per pixel (zero padded to the step of the kernels) applied to
+    // the source pixels from mBegin on
+    struct Axis{
+        int mTaps=0;
+        std::vector<int> mBegin;
+        std::vector<short> mFixed;
+        std::vector<double> mWeights;
+    };
+private:
+    cv::Mat mInImg, mOutImg;
+    Axis mX, mY;
+};
+
+# endif // IMG_RESIZE_ENGINE_H
@@ -1,6 +1,7 @@
 #include <thread>
 #include <vector>
 
+#include "imgResizeEngine.h"
 #include "imgResizeThreads.h"
 
 class ThreadsGuard
@@ -21,40 +22,27 @@ private:
     std::vector<std::thread>& mThrVec;
 };
 
-void threadResizeTask(cv::Mat inImg, cv::Mat outImg)
-{
-    cv::resize(inImg, outImg, cv::Size(outImg.cols, outImg.rows));
-}
-
 void imageResizeThreads(const cv::Mat& inImg,
                         cv::Mat& outImg,
                         const cv::Size& outSize,
-                        int thrNum)
+                        int thrNum,
+                        ResizeFilter filter)
 {
-    if (thrNum==1){
-        cv::resize(inImg, outImg, outSize);
-        return;
-    }
-    cv::Mat resImg(outSize.height, outSize.width, inImg.type());
+    if (thrNum<1)
+        thrNum=1;
+    cv::Mat resImg;
+    // bands of output rows, every one reads its own source window
+    ResizeEngine engine(inImg, resImg, outSize, filter);
     std::vector<std::thread> threads(thrNum-1); //minus 1 for main thread!
     {
         ThreadsGuard threadsJoiner(threads);
-        int inStep=inImg.rows/thrNum;
-        int resStep=outSize.height/thrNum;
-        int inRowBeg=0, inRowEnd=inStep;
-        int resRowBeg=0, resRowEnd=resStep;
-        for (auto& thr: threads){
-            thr=std::thread(threadResizeTask,
-                            inImg.rowRange(inRowBeg, inRowEnd),
-                            resImg.rowRange(resRowBeg, resRowEnd));
-            inRowBeg=inRowEnd;
-            inRowEnd+=inStep;
-            resRowBeg=resRowEnd;
-            resRowEnd+=resStep;
+        for (int i=0; i<thrNum-1; ++i){
+            threads[i]=std::thread(&ResizeEngine::resizeRows, &engine,
+                                   engine.bandBegin(i, thrNum),
+                                   engine.bandBegin(i+1, thrNum));
         }
         // also do part of the work in the main thread
-        threadResizeTask(inImg.rowRange(inRowBeg, inImg.rows),
-                         resImg.rowRange(resRowBeg, outSize.height));
+        engine.resizeRows(engine.bandBegin(thrNum-1, thrNum), engine.rows());
     }
     outImg=std::move(resImg);
 }
@@ -9,17 +9,23 @@
 #define IMG_RESIZE_THREADS_H
 
 #include <opencv2/opencv.hpp>
+
+#include "imgResizeEngine.h"
 /**
  * @brief imageResizeThreads Resizes images using specified number of threads
+ * (bands of output rows of ResizeEngine, the result doesn't depend on
+ * the number of threads)
  * @param inImg Initial image to resize.
  * @param outImg Resized image for output.
  * @param outSize Size to which initial image should be resized.
  * @param threadsNumber Number of threads to use.
+ * @param filter Resampling filter.
  */
 void imageResizeThreads(const cv::Mat &inImg,
                        cv::Mat &outImg,
                        const cv::Size& outSize,
-                       int threadsNumber);
+                       int threadsNumber,
+                       ResizeFilter filter=ResizeFilter::Bilinear);
 
 
 # endif // IMG_RESIZE_THREADS_H
@@ -5,13 +5,23 @@ CONFIG -= qt
 
 QMAKE_CXXFLAGS +=-g -Wall -Wextra -Wpedantic -std=c++14 -pthread
 
+# the resampler is shared with task1-threads
+RESIZE_ENGINE_DIR = ../../task1-threads/src
+
 SOURCES += \
     engineMain.cpp \
-    imgthreadpool.cpp
+    imgthreadpool.cpp \
+    imgdecode.cpp \
+    thumbpipeline.cpp \
+    $$RESIZE_ENGINE_DIR/imgResizeEngine.cpp
 
 HEADERS += \
     imgthreadpool.h \
-    exectimerclass.h
+    imgdecode.h \
+    boundedqueue.h \
+    thumbpipeline.h \
+    exectimerclass.h \
+    $$RESIZE_ENGINE_DIR/imgResizeEngine.h
 
 LIBS += \
     -pthread -lboost_system -lboost_filesystem \
@@ -19,4 +29,5 @@ LIBS += \
     -lopencv_highgui -lopencv_imgcodecs
 
 INCLUDEPATH += \
+    $$RESIZE_ENGINE_DIR \
     /usr/local/include/opencv
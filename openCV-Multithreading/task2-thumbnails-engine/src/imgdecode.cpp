@@ -0,0 +1,168 @@
+/**
+ * @brief Reduced decoding of images for thumbnails.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+#include "imgdecode.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace {
+
+// bytes of data from pos on, -1 past its end
+int readByte(const std::vector<uchar>& data, std::size_t& pos){
+    return pos<data.size() ? data[pos++] : -1;
+}
+
+// big endian 16-bit value
+int readWord(const std::vector<uchar>& data, std::size_t& pos){
+    int hi=readByte(data, pos), lo=readByte(data, pos);
+    return hi<0 || lo<0 ? -1 : hi<<8|lo;
+}
+
+bool isFrameMarker(int marker){
+    // SOF0..SOF15 except DHT, JPG and DAC
+    return marker>=0xC0 && marker<=0xCF &&
+           marker!=0xC4 && marker!=0xC8 && marker!=0xCC;
+}
+
+// unsigned value of bytes bytes at pos, 0 past the end of data
+std::size_t readUnsigned(const std::vector<uchar>& data, std::size_t pos,
+                         int bytes, bool isBigEndian){
+    if (pos+bytes>data.size())
+        return 0;
+    std::size_t value=0;
+    for (int i=0; i<bytes; ++i){
+        int shift=8*(isBigEndian ? bytes-1-i : i);
+        value|=std::size_t(data[pos+i])<<shift;
+    }
+    return value;
+}
+
+// bytes of a PNG image decoded with IMREAD_UNCHANGED, from its IHDR
+// chunk; 0 if it isn't a PNG image
+std::size_t pngBytes(const std::vector<uchar>& data){
+    static const uchar signature[]={0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A,
+                                    0x0A, 0, 0, 0, 13, 'I', 'H', 'D', 'R'};
+    if (data.size()<26 ||
+        !std::equal(std::begin(signature), std::end(signature), data.begin()))
+        return 0;
+    std::size_t width=readUnsigned(data, 16, 4, true);
+    std::size_t height=readUnsigned(data, 20, 4, true);
+    int depth=data[24], colorType=data[25];
+    // gray, RGB (BGR), palette and alpha types; gray with alpha and
+    // palette with transparency decode to BGRA
+    int channels=colorType==0 ? 1 : colorType==2 ? 3 : 4;
+    return width*height*channels*(depth==16 ? 2 : 1);
+}
+
+// same for a BMP image, palette images are counted as BGR
+std::size_t bmpBytes(const std::vector<uchar>& data){
+    if (data.size()<30 || data[0]!='B' || data[1]!='M')
+        return 0;
+    std::size_t width, height, bitCount;
+    if (readUnsigned(data, 14, 4, false)==12){ // OS/2 core header
+        width=readUnsigned(data, 18, 2, false);
+        height=readUnsigned(data, 20, 2, false);
+        bitCount=readUnsigned(data, 24, 2, false);
+    } else {
+        width=readUnsigned(data, 18, 4, false);
+        // top-down images have a negative height
+        std::int32_t rows=std::int32_t(readUnsigned(data, 22, 4, false));
+        height=std::size_t(rows<0 ? -std::int64_t(rows) : rows);
+        bitCount=readUnsigned(data, 28, 2, false);
+    }
+    return width*height*(bitCount==32 ? 4 : 3);
+}
+
+} // namespace
+
+bool readJpegHeader(const std::vector<uchar>& data,
+                    cv::Size& imgSize,
+                    int& components)
+{
+    std::size_t pos=0;
+    if (readWord(data, pos)!=0xFFD8) // SOI
+        return false;
+    while (readByte(data, pos)==0xFF){
+        int marker=readByte(data, pos);
+        while (marker==0xFF) // fill bytes
+            marker=readByte(data, pos);
+        if (marker==0x01 || (marker>=0xD0 && marker<=0xD7))
+            continue; // markers without a segment
+        if (marker<0 || marker==0xD9 || marker==0xDA) // EOI, SOS: no frame
+            return false;
+        int length=readWord(data, pos);
+        if (length<2)
+            return false;
+        if (isFrameMarker(marker)){
+            readByte(data, pos); // sample precision
+            int height=readWord(data, pos), width=readWord(data, pos);
+            components=readByte(data, pos);
+            if (height<=0 || width<=0 || components<0)
+                return false;
+            imgSize=cv::Size(width, height);
+            return true;
+        }
+        pos+=length-2;
+    }
+    return false;
+}
+
+int jpegReduction(const cv::Size& imgSize, const cv::Size& outSize)
+{
+    // libjpeg rounds the scaled size up
+    for (int denom=8; denom>1; denom/=2){
+        if ((imgSize.width+denom-1)/denom>=outSize.width &&
+            (imgSize.height+denom-1)/denom>=outSize.height)
+            return denom;
+    }
+    return 1;
+}
+
+std::size_t reducedBytes(const std::vector<uchar>& data,
+                         const cv::Size& outSize)
+{
+    cv::Size imgSize;
+    int components=0;
+    if (!readJpegHeader(data, imgSize, components)){
+        // other formats are decoded as they are
+        std::size_t bytes=pngBytes(data);
+        return bytes ? bytes : bmpBytes(data);
+    }
+    int denom=jpegReduction(imgSize, outSize);
+    std::size_t width=(imgSize.width+denom-1)/denom;
+    std::size_t height=(imgSize.height+denom-1)/denom;
+    return width*height*(components==1 ? 1 : 3);
+}
+
+cv::Mat imdecodeReduced(const std::vector<uchar>& data,
+                        const cv::Size& outSize)
+{
+    cv::Size imgSize;
+    int components=0;
+    int denom=1;
+    if (readJpegHeader(data, imgSize, components))
+        denom=jpegReduction(imgSize, outSize);
+    if (denom==1)
+        return cv::imdecode(data, cv::IMREAD_UNCHANGED);
+    bool isGray=components==1;
+    int flags;
+    switch (denom){
+    case 2:
+        flags=isGray ? cv::IMREAD_REDUCED_GRAYSCALE_2
+                     : cv::IMREAD_REDUCED_COLOR_2;
+        break;
+    case 4:
+        flags=isGray ? cv::IMREAD_REDUCED_GRAYSCALE_4
+                     : cv::IMREAD_REDUCED_COLOR_4;
+        break;
+    default:
+        flags=isGray ? cv::IMREAD_REDUCED_GRAYSCALE_8
+                     : cv::IMREAD_REDUCED_COLOR_8;
+    }
+    // IMREAD_UNCHANGED ignores EXIF orientation, so thumbnails do too
+    return cv::imdecode(data, flags | cv::IMREAD_IGNORE_ORIENTATION);
+}
@@ -0,0 +1,47 @@
+/**
+ * @brief Decoding of images for thumbnails. JPEG files are decoded
+ * by libjpeg in the DCT domain at 1/2, 1/4 or 1/8 of their size when
+ * the thumbnail is small enough, which skips most of the decode work
+ * and memory of large photos.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+#ifndef IMGDECODE_H
+#define IMGDECODE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief readJpegHeader Reads the size and the number of components of
+ * a JPEG image from its frame header without decoding the image.
+ * @param data Contents of an image file.
+ * @return false if it isn't a JPEG image or its header is broken.
+ */
+bool readJpegHeader(const std::vector<uchar>& data,
+                    cv::Size& imgSize,
+                    int& components);
+
+// the largest DCT scale denominator (8, 4, 2 or 1) with which an image
+// of imgSize is decoded to at least outSize
+int jpegReduction(const cv::Size& imgSize, const cv::Size& outSize);
+
+// bytes of the image which imdecodeReduced decodes from data for outSize,
+// read from the header of JPEG, PNG and BMP files; 0 for other formats
+std::size_t reducedBytes(const std::vector<uchar>& data,
+                         const cv::Size& outSize);
+
+/**
+ * @brief imdecodeReduced Decodes an image to be resized to outSize: JPEG
+ * images are decoded at the largest reduction which stays at or above
+ * outSize (in color or grayscale as the file is, the orientation is
+ * the same as of cv::IMREAD_UNCHANGED), other images as they are.
+ * @param data Contents of an image file.
+ * @return An empty image if it can't be decoded.
+ */
+cv::Mat imdecodeReduced(const std::vector<uchar>& data,
+                        const cv::Size& outSize);
+
+#endif // IMGDECODE_H
@@ -0,0 +1,315 @@
+/**
+ * @brief Streaming thumbnail pipeline implementation.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+#include "thumbpipeline.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <boost/filesystem.hpp>
+
+#include "imgdecode.h"
+#include "imgthreadpool.h"
+#include "imgResizeEngine.h"
+
+namespace {
+
+void imageResize(const cv::Mat& inImg,
+                 cv::Mat& outImg,
+                 const cv::Size& outSize,
+                 ThreadPool* poolPtr)
+{
+    cv::Mat resImg;
+    // thumbnails average all the source pixels they cover; bands of
+    // output rows read their own source windows, so there are no seams
+    ResizeEngine engine(inImg, resImg, outSize, ResizeFilter::Area);
+    int taskNum = std::min(poolPtr->getThreadsNum()*2, engine.rows());
+    std::vector<std::future<void>> resResults(taskNum-1); //-1 for this thread
+    for (int i=0; i<taskNum-1; ++i){
+        resResults[i] = poolPtr->submit(&ResizeEngine::resizeRows, &engine,
+                                        engine.bandBegin(i, taskNum),
+                                        engine.bandBegin(i+1, taskNum));
+    }
+    // also do part of the work in this thread
+    engine.resizeRows(engine.bandBegin(taskNum-1, taskNum), engine.rows());
+
+    // wait for future and do some tasks until it will be ready
+    for (auto& resResult: resResults){
+        while (resResult.wait_for(std::chrono::seconds(0))==
+                                  std::future_status::timeout){
+            poolPtr->runPoolTask();
+        }
+        resResult.get();
+    }
+    outImg=std::move(resImg);
+}
+
+std::size_t bytesOf(const ThumbnailJob& job)
+{
+    return job.mData.size()+job.mImage.total()*job.mImage.elemSize()+
+           job.mReserved;
+}
+
+} // namespace
+
+void MemoryBudget::change(std::ptrdiff_t delta)
+{
+    {
+        std::lock_guard<std::mutex> lck(mMutex);
+        mUsed+=delta;
+        mPeak=std::max(mPeak, mUsed);
+    }
+    if (delta<0)
+        mBelowCap.notify_all();
+}
+
+void MemoryBudget::changeUnknown(int delta)
+{
+    {
+        std::lock_guard<std::mutex> lck(mMutex);
+        mUnknown+=delta;
+    }
+    if (delta<0)
+        mBelowCap.notify_all();
+}
+
+void MemoryBudget::waitBelowCap()
+{
+    std::unique_lock<std::mutex> lck(mMutex);
+    mBelowCap.wait(lck, [this]{return mUsed<mCap && mUnknown==0;});
+}
+
+std::size_t MemoryBudget::getPeak()
+{
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mPeak;
+}
+
+ThumbnailPipeline::ThumbnailPipeline(const std::string& imgFolder,
+                                     const std::string& outFolder,
+                                     const cv::Size& outSize,
+                                     std::size_t memoryCap,
+                                     ThreadPool* poolPtr)
+    : mImgFolder(imgFolder),
+      mOutFolder(outFolder),
+      mOutSize(outSize),
+      mPoolPtr(poolPtr),
+      mBudget(memoryCap),
+      mPaths(mQueueCapacity),
+      mFiles(mQueueCapacity),
+      mDecoded(mQueueCapacity),
+      mResized(mQueueCapacity),
+      mEncoded(mQueueCapacity)
+{
+}
+
+std::size_t ThumbnailPipeline::run()
+{
+    std::vector<std::thread> stages;
+    {
+        ThreadsGuard stagesJoiner(stages);
+        stages.push_back(std::thread(&ThumbnailPipeline::scanStage, this));
+        stages.push_back(std::thread(&ThumbnailPipeline::readStage, this));
+        stages.push_back(std::thread(&ThumbnailPipeline::decodeStage, this));
+        stages.push_back(std::thread(&ThumbnailPipeline::resizeStage, this));
+        stages.push_back(std::thread(&ThumbnailPipeline::encodeStage, this));
+        writeStage();
+    }
+    return mWritten;
+}
+
+// the bytes held by the job go to the budget
+void ThumbnailPipeline::account(ThumbnailJob& job)
+{
+    std::size_t bytes=bytesOf(job);
+    mBudget.change(std::ptrdiff_t(bytes)-std::ptrdiff_t(job.mBytes));
+    job.mBytes=bytes;
+}
+
+// process of a stage, false if the job is to be dropped
+template <typename Fn>
+bool ThumbnailPipeline::processJob(ThumbnailJob& job, Fn& process)
+{
+    try {
+        return process(job);
+    } catch (const std::exception& ex) {
+        std::cout << "Skipped " << job.mName << ": " << ex.what()
+                  << std::endl;
+    }
+    return false;
+}
+
+// a kept job goes to out, a dropped one releases its memory
+void ThumbnailPipeline::passJob(ThumbnailJob& job, bool isKept,
+                                JobQueue* out)
+{
+    // the size of an image is known once it is decoded or dropped,
+    // it is in the budget before more files are read
+    bool isSized=job.mIsUnknown && (!isKept || !job.mImage.empty());
+    if (!isKept){
+        mBudget.change(-std::ptrdiff_t(job.mBytes));
+        job=ThumbnailJob();
+    } else {
+        account(job);
+    }
+    if (isSized){
+        job.mIsUnknown=false;
+        mBudget.changeUnknown(-1);
+    }
+    if (isKept && out)
+        out->push(std::move(job));
+}
+
+/**
+ * @brief ThumbnailPipeline::runStage Applies process to the jobs of in
+ * until it is closed and drained. Jobs for which process returns true
+ * go to out, the others are dropped; out is closed at the end.
+ */
+template <typename Fn>
+void ThumbnailPipeline::runStage(JobQueue& in, JobQueue* out, Fn process)
+{
+    ThumbnailJob job;
+    while (in.pop(job)){
+        bool isKept=processJob(job, process);
+        passJob(job, isKept, out);
+    }
+    if (out)
+        out->close();
+}
+
+/**
+ * @brief ThumbnailPipeline::runPoolStage As runStage, but process runs
+ * as pool tasks, up to one per pool thread; jobs go to out in the order
+ * of in. Tasks return their jobs instead of pushing them, so a pool
+ * thread never waits for a queue (resize runs pool tasks while it
+ * waits for its bands, a task blocked on its queue would stop it).
+ */
+template <typename Fn>
+void ThumbnailPipeline::runPoolStage(JobQueue& in, JobQueue& out, Fn process)
+{
+    struct Done{
+        ThumbnailJob mJob;
+        bool mIsKept;
+    };
+    std::deque<std::future<Done>> tasks;
+    std::size_t maxTasks=std::max(mPoolPtr->getThreadsNum(), 1);
+    auto passOldest=[&]{
+        Done done=tasks.front().get();
+        tasks.pop_front();
+        passJob(done.mJob, done.mIsKept, &out);
+    };
+    ThumbnailJob job;
+    for (;;){
+        // finished jobs go on while no new one is waiting, the read
+        // stage may wait for the memory they release
+        if (!tasks.empty() && !in.tryPop(job)){
+            passOldest();
+            continue;
+        }
+        if (tasks.empty() && !in.pop(job))
+            break;
+        if (tasks.size()>=maxTasks)
+            passOldest();
+        tasks.push_back(mPoolPtr->submit(
+            [this, process, job=std::move(job)]() mutable {
+                bool isKept=processJob(job, process);
+                return Done{std::move(job), isKept};
+            }));
+        job=ThumbnailJob();
+    }
+    out.close();
+}
+
+void ThumbnailPipeline::scanStage()
+{
+    try {
+        namespace fs=boost::filesystem;
+        for (fs::directory_iterator it(mImgFolder), end; it!=end; ++it){
+            if (!fs::is_regular_file(it->status()))
+                continue;
+            ThumbnailJob job;
+            job.mName=it->path().filename().string();
+            mPaths.push(std::move(job));
+        }
+    } catch (const std::exception& ex) {
+        std::cout << "Unable to scan " << mImgFolder << ": " << ex.what()
+                  << std::endl;
+    }
+    mPaths.close();
+}
+
+void ThumbnailPipeline::readStage()
+{
+    runStage(mPaths, &mFiles, [this](ThumbnailJob& job){
+        // new files enter while the images held fit the cap
+        mBudget.waitBelowCap();
+        std::ifstream file(mImgFolder+"/"+job.mName, std::ios::binary);
+        job.mData.assign(std::istreambuf_iterator<char>(file),
+                         std::istreambuf_iterator<char>());
+        // the decoded image is counted from the start, small files of
+        // large images would pass the cap otherwise; while an image of
+        // other formats isn't decoded, no more files are read
+        job.mReserved=reducedBytes(job.mData, mOutSize);
+        if (job.mReserved==0 && !job.mData.empty()){
+            job.mIsUnknown=true;
+            mBudget.changeUnknown(1);
+        }
+        return !job.mData.empty();
+    });
+}
+
+void ThumbnailPipeline::decodeStage()
+{
+    runPoolStage(mFiles, mDecoded, [this](ThumbnailJob& job){
+        // JPEG files are decoded reduced close to the thumbnail size
+        job.mImage=imdecodeReduced(job.mData, mOutSize);
+        std::vector<uchar>().swap(job.mData);
+        job.mReserved=0;
+        return !job.mImage.empty();
+    });
+}
+
+void ThumbnailPipeline::resizeStage()
+{
+    runStage(mDecoded, &mResized, [this](ThumbnailJob& job){
+        cv::Mat outImg;
+        imageResize(job.mImage, outImg, mOutSize, mPoolPtr);
+        job.mImage=outImg;
+        return true;
+    });
+}
+
+void ThumbnailPipeline::encodeStage()
+{
+    runPoolStage(mResized, mEncoded, [](ThumbnailJob& job){
+        // the format of the source file
+        auto dot=job.mName.rfind('.');
+        if (dot==std::string::npos)
+            throw std::runtime_error("no file extension");
+        bool isEncoded=cv::imencode(job.mName.substr(dot), job.mImage,
+                                    job.mData);
+        job.mImage.release();
+        return isEncoded;
+    });
+}
+
+void ThumbnailPipeline::writeStage()
+{
+    runStage(mEncoded, nullptr, [this](ThumbnailJob& job){
+        std::string outName=mOutFolder+"/"+job.mName;
+        std::ofstream file(outName, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(job.mData.data()),
+                   job.mData.size());
+        if (!file)
+            throw std::runtime_error("unable to write "+outName);
+        ++mWritten;
+        std::cout << "Saved " << outName << std::endl;
+        return false; // done, its memory is released
+    });
+}
@@ -0,0 +1,107 @@
+/**
+ * @brief Streaming thumbnail pipeline: scan -> read -> decode -> resize
+ * -> encode -> write stages joined by bounded queues, so only a few
+ * images are in memory however large the folder is.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+#ifndef THUMBPIPELINE_H
+#define THUMBPIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "boundedqueue.h"
+
+class ThreadPool;
+
+/**
+ * @brief The MemoryBudget class Bytes of images held by the pipeline.
+ * Stages change them as their buffers grow and shrink, new files are
+ * read only while they are below the cap and no image of unknown size
+ * waits to be decoded, so it is exceeded by one image at most.
+ */
+class MemoryBudget
+{
+public:
+    explicit
+    MemoryBudget(std::size_t cap): mCap(cap){}
+    MemoryBudget(const MemoryBudget& mb)=delete;
+    MemoryBudget& operator=(const MemoryBudget& mb)=delete;
+    void change(std::ptrdiff_t delta);
+    // images read, which decoded size isn't known from their headers
+    void changeUnknown(int delta);
+    void waitBelowCap();
+    std::size_t getPeak();
+private:
+    std::size_t mCap, mUsed=0, mPeak=0;
+    int mUnknown=0;
+    std::mutex mMutex;
+    std::condition_variable mBelowCap;
+};
+
+// an image on its way through the stages
+struct ThumbnailJob{
+    std::string mName;          // file name in the folder
+    std::vector<uchar> mData;   // file contents, then the encoded thumbnail
+    cv::Mat mImage;             // decoded, then resized image
+    std::size_t mReserved=0;    // expected bytes of the decoded image
+    std::size_t mBytes=0;       // bytes of the job in the budget
+    bool mIsUnknown=false;      // not decoded, mReserved isn't known
+};
+
+/**
+ * @brief The ThumbnailPipeline class Scan, read, resize and write run in
+ * their own threads. Decode and encode are tasks of the pool, as many
+ * images at once as it has threads, and resize splits images into bands
+ * on it, so the codecs overlap with resizing on all cores. Files which
+ * can't be read, decoded or encoded are skipped.
+ */
+class ThumbnailPipeline
+{
+public:
+    ThumbnailPipeline(const std::string& imgFolder,
+                      const std::string& outFolder,
+                      const cv::Size& outSize,
+                      std::size_t memoryCap,
+                      ThreadPool* poolPtr);
+    ThumbnailPipeline(const ThumbnailPipeline& tp)=delete;
+    ThumbnailPipeline& operator=(const ThumbnailPipeline& tp)=delete;
+    // processes the folder, returns the number of thumbnails written
+    std::size_t run();
+    // the most bytes of images held at once
+    std::size_t getPeakMemory() {return mBudget.getPeak();}
+
+    static const std::size_t mQueueCapacity=4;
+private:
+    using JobQueue=BoundedQueue<ThumbnailJob>;
+
+    std::string mImgFolder, mOutFolder;
+    cv::Size mOutSize;
+    ThreadPool* mPoolPtr;
+    MemoryBudget mBudget;
+    JobQueue mPaths, mFiles, mDecoded, mResized, mEncoded;
+    std::size_t mWritten=0;
+
+    void scanStage();
+    void readStage();
+    void decodeStage();
+    void resizeStage();
+    void encodeStage();
+    void writeStage();
+    template <typename Fn>
+    void runStage(JobQueue& in, JobQueue* out, Fn process);
+    template <typename Fn>
+    void runPoolStage(JobQueue& in, JobQueue& out, Fn process);
+    template <typename Fn>
+    bool processJob(ThumbnailJob& job, Fn& process);
+    void passJob(ThumbnailJob& job, bool isKept, JobQueue* out);
+    void account(ThumbnailJob& job);
+};
+
+#endif // THUMBPIPELINE_H
@@ -0,0 +1,268 @@
+/**
+ * @brief Solver benchmarks on the bundled corpora (bench/data),
+ * one benchmark per corpus and engine configuration.
+ * Branching policies are compared on the Propagation engine,
+ * solveByOrder shows how solve time grows with the board order.
+ * Every iteration solves the next puzzle of the corpus, items/s is
+ * puzzles/s and p50/p90/p99/max counters are per-puzzle latencies
+ * in microseconds. generatePuzzles benchmarks measure puzzles/s of
+ * the generator on one thread, canonicalizeCorpus ones - the price of
+ * a SolutionCache lookup. lockstepCorpus ones solve lockstepWidth()
+ * puzzles per iteration, items/s is still puzzles/s.
+ * Run from the sudoku folder (make bench).
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include "canonical.h"
+#include "generator.h"
+#include "lockstep.h"
+#include "puzzleio.h"
+#include "sudoku.h"
+
+#ifndef SUDOKU_BENCH_DATA
+#define SUDOKU_BENCH_DATA "bench/data"
+#endif
+
+namespace {
+
+// Propagation engine with Branching::Mrv unless it says otherwise
+enum class Config {Propagation, Deductions, DancingLinks, MrvDegree,
+                   LeastConstraining, RandomRestarts};
+
+std::vector<Board>& corpus(const std::string& name){
+    // corpora are loaded once, benchmarks run one after another
+    static std::map<std::string, std::vector<Board>> corpora;
+    auto it=corpora.find(name);
+    if (it!=corpora.end())
+        return it->second;
+    MappedFile file(std::string(SUDOKU_BENCH_DATA)+"/"+name);
+    std::vector<Board> puzzles;
+    Board board;
+    for (const char *beg=file.begin(), *eol; beg<file.end(); beg=eol+1){
+        eol=static_cast<const char*>(
+                std::memchr(beg, '\n', file.end()-beg));
+        if (!eol)
+            eol=file.end();
+        if (eol!=beg && *beg!='#' && parsePuzzleLine(beg, eol, board))
+            puzzles.push_back(board);
+    }
+    if (puzzles.empty())
+        throw std::runtime_error("No puzzles in "+name);
+    return corpora[name]=std::move(puzzles);
+}
+
+// Latin square like boards of any order: pattern grid with shuffled
+// digits, bands, stacks and lines inside them, cluesPercent of cells
+// are kept. They have many solutions, the search stops at the first one.
+std::vector<Board>& orderPuzzles(int box, int cluesPercent){
+    static std::map<std::pair<int, int>, std::vector<Board>> sets;
+    auto& puzzles=sets[std::make_pair(box, cluesPercent)];
+    if (!puzzles.empty())
+        return puzzles;
+    int side=box*box;
+    std::mt19937 rng(box*100+cluesPercent);
+    std::vector<int> rows(side), cols(side), digits(side), groups(box);
+    auto shuffleLines=[&rng, &groups, box](std::vector<int>& lines){
+        std::iota(groups.begin(), groups.end(), 0);
+        std::shuffle(groups.begin(), groups.end(), rng);
+        for (int k=0; k<box; ++k){
+            auto first=lines.begin()+k*box;
+            std::iota(first, first+box, groups[k]*box);
+            std::shuffle(first, first+box, rng);
+        }
+    };
+    for (int ind=0; ind<16; ++ind){
+        shuffleLines(rows);
+        shuffleLines(cols);
+        std::iota(digits.begin(), digits.end(), 1);
+        std::shuffle(digits.begin(), digits.end(), rng);
+        Board board(side);
+        for (int i=0; i<side; ++i)
+            for (int j=0; j<side; ++j){
+                int val=(box*(rows[i]%box)+rows[i]/box+cols[j])%side;
+                if (int(rng()%100)<cluesPercent)
+                    board[i][j]=digits[val];
+            }
+        puzzles.push_back(board);
+    }
+    return puzzles;
+}
+
+void solvePuzzles(benchmark::State& state, const std::vector<Board>& puzzles,
+                  Config config){
+    std::vector<double> latencies;
+    Board board;
+    std::size_t ind=0;
+    long long failed=0;
+    for (auto _: state){
+        auto sTime=std::chrono::steady_clock::now();
+        board=puzzles[ind];
+        Table table(board.view());
+        if (config==Config::DancingLinks)
+            table.setEngine(Table::Engine::DancingLinks);
+        else if (config==Config::Deductions)
+            table.setDeductions(Deductions::all());
+        else if (config==Config::MrvDegree)
+            table.setBranching(Branching::MrvDegree);
+        else if (config==Config::LeastConstraining)
+            table.setBranching(Branching::LeastConstraining);
+        else if (config==Config::RandomRestarts)
+            table.setBranching(Branching::RandomRestarts);
+        bool isSolved=table.solve();
+        benchmark::DoNotOptimize(isSolved);
+        std::chrono::duration<double, std::micro> durTime=
+            std::chrono::steady_clock::now()-sTime;
+        latencies.push_back(durTime.count());
+        failed+=!isSolved;
+        if (++ind==puzzles.size())
+            ind=0;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (latencies.empty())
+        return;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile=[&latencies](double part){
+        return latencies[std::size_t(part*(latencies.size()-1))];
+    };
+    state.counters["p50_us"]=percentile(0.5);
+    state.counters["p90_us"]=percentile(0.9);
+    state.counters["p99_us"]=percentile(0.99);
+    state.counters["max_us"]=latencies.back();
+    if (failed)
+        state.SkipWithError("some puzzles are not solved");
+}
+
+void solveCorpus(benchmark::State& state, const char* name, Config config){
+    solvePuzzles(state, corpus(name), config);
+}
+
+// range(0) - box side, range(1) - percent of cells given
+void solveByOrder(benchmark::State& state){
+    solvePuzzles(state, orderPuzzles(state.range(0), state.range(1)),
+                 Config::Propagation);
+}
+
+void orderArgs(benchmark::internal::Benchmark* bench){
+    for (int box=3; box<=maxBoardBox; ++box)
+        for (int cluesPercent: {0, 65})
+            bench->Args({box, cluesPercent});
+}
+
+// every iteration generates the next puzzle of the seed on one thread
+void generatePuzzles(benchmark::State& state, int box,
+                     Difficulty difficulty){
+    GeneratorOptions options;
+    options.mBox=box;
+    options.mDifficulty=difficulty;
+    PuzzleGenerator generator(options);
+    Board puzzle;
+    std::uint64_t ind=0;
+    for (auto _: state){
+        bool isDone=generator.generate(ind++, puzzle);
+        benchmark::DoNotOptimize(isDone);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void canonicalizeCorpus(benchmark::State& state, const char* name){
+    auto& puzzles=corpus(name);
+    Board canonical;
+    BoardTransform transform;
+    std::size_t ind=0;
+    for (auto _: state){
+        bool isDone=canonicalize(puzzles[ind].view(), canonical, transform);
+        benchmark::DoNotOptimize(isDone);
+        if (++ind==puzzles.size())
+            ind=0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// every iteration solves the next lockstepWidth() puzzles at once
+void lockstepCorpus(benchmark::State& state, const char* name){
+    auto& puzzles=corpus(name);
+    std::size_t width=lockstepWidth(), ind=0;
+    std::vector<Board> boards(width);
+    std::vector<BoardView> views;
+    for (auto& board: boards)
+        views.push_back(board.view());
+    std::vector<SolveResult> results(width);
+    long long failed=0;
+    for (auto _: state){
+        for (std::size_t k=0; k<width; ++k){
+            boards[k]=puzzles[ind];
+            if (++ind==puzzles.size())
+                ind=0;
+        }
+        trySolveLockstep(views.data(), results.data(), width);
+        for (auto& result: results)
+            failed+=!result.isSolved();
+    }
+    state.SetItemsProcessed(state.iterations()*width);
+    state.SetLabel(lockstepIsa());
+    if (failed)
+        state.SkipWithError("some puzzles are not solved");
+}
+
+} // namespace
+
+#define SUDOKU_BENCH_CORPUS(corpus, file) \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_propagation, file, \
+                      Config::Propagation)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_deductions, file, \
+                      Config::Deductions)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_dlx, file, \
+                      Config::DancingLinks)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_mrvDegree, file, \
+                      Config::MrvDegree)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_leastConstraining, file, \
+                      Config::LeastConstraining) \
+                      ->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_CAPTURE(solveCorpus, corpus##_randomRestarts, file, \
+                      Config::RandomRestarts)->Unit(benchmark::kMicrosecond)
+
+SUDOKU_BENCH_CORPUS(easy9, "easy9.txt");
+SUDOKU_BENCH_CORPUS(clue17, "clue17.txt");
+SUDOKU_BENCH_CORPUS(hardest9, "hardest9.txt");
+SUDOKU_BENCH_CORPUS(order4, "order4.txt");
+SUDOKU_BENCH_CORPUS(order5, "order5.txt");
+
+BENCHMARK_CAPTURE(lockstepCorpus, easy9, "easy9.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(lockstepCorpus, clue17, "clue17.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(lockstepCorpus, hardest9, "hardest9.txt")
+    ->Unit(benchmark::kMicrosecond);
+
+// solve time scaling by board order, 9x9 up to 64x64
+BENCHMARK(solveByOrder)->ArgNames({"box", "clues%"})->Apply(orderArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_CAPTURE(canonicalizeCorpus, clue17, "clue17.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(canonicalizeCorpus, order4, "order4.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(canonicalizeCorpus, order5, "order5.txt")
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_CAPTURE(generatePuzzles, minimal9, 3, Difficulty::Any)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(generatePuzzles, easy9, 3, Difficulty::Easy)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(generatePuzzles, hard9, 3, Difficulty::Hard)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(generatePuzzles, minimal16, 4, Difficulty::Any)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
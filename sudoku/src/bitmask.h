@@ -0,0 +1,129 @@
+/*
+ * bitmask.h
+ *
+ * Fixed width candidates mask for the sudoku solver.
+ * Storage is chosen at compile time by number of bits:
+ * uint16_t, uint32_t, uint64_t or several uint64_t words.
+ * None of the operations allocate memory.
+ *
+ */
+
+#ifndef SUDOKU_BITMASK_H
+#define SUDOKU_BITMASK_H
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+template <int Bits>
+class BitMask
+{
+    static_assert(Bits>0, "BitMask must hold at least one bit");
+public:
+    using Word = typename std::conditional<(Bits<=16), std::uint16_t,
+                 typename std::conditional<(Bits<=32), std::uint32_t,
+                                           std::uint64_t>::type>::type;
+    static constexpr int mWordBits = 8*sizeof(Word);
+    static constexpr int mWords = (Bits+mWordBits-1)/mWordBits;
+
+    BitMask(){ // all bits set
+        for (auto& el: mVal) el=Word(~Word(0));
+        mVal.back()=lastWordMask();
+    }
+    static BitMask empty(){BitMask res; res.clear(); return res;}
+    static BitMask single(int ind){return empty().set(ind);}
+
+    bool operator==(const BitMask& rhs) const {return mVal==rhs.mVal;}
+    bool operator!=(const BitMask& rhs) const {return mVal!=rhs.mVal;}
+    BitMask& operator|=(const BitMask& rhs){
+        for (int i=0; i<mWords; ++i) mVal[i]|=rhs.mVal[i];
+        return *this;
+    }
+    BitMask& operator&=(const BitMask& rhs){
+        for (int i=0; i<mWords; ++i) mVal[i]&=rhs.mVal[i];
+        return *this;
+    }
+    BitMask& operator^=(const BitMask& rhs){
+        for (int i=0; i<mWords; ++i) mVal[i]^=rhs.mVal[i];
+        return *this;
+    }
+    BitMask operator~() const {
+        BitMask res(*this);
+        for (auto& el: res.mVal) el=Word(~el);
+        res.mVal.back()&=lastWordMask();
+        return res;
+    }
+
+    int getIndex() const; // returns index of a highest bit set
+    int getLowIndex() const; // returns index of a lowest bit set
+    BitMask& unSet(int ind){ //unsets bit with index 'ind'
+        --ind;
+        mVal[ind/mWordBits]&=Word(~(Word(1)<<(ind%mWordBits)));
+        return *this;
+    }
+    BitMask& set(int ind){ //sets bit with index 'ind'
+        --ind;
+        mVal[ind/mWordBits]|=Word(1)<<(ind%mWordBits);
+        return *this;
+    }
+    int getBit(int ind) const { // returns bit with index 'ind'
+        --ind;
+        return (mVal[ind/mWordBits]>>(ind%mWordBits))&1;
+    }
+    int getBitsNum() const; //returns a number of nonzero bits
+    bool any() const {
+        for (auto el: mVal) if (el) return true;
+        return false;
+    }
+    void clear(){for (auto& el: mVal) el=0;} // clear all bits
+    Word getWord(int i) const {return mVal[i];}
+
+private:
+    std::array<Word, mWords> mVal;
+
+    static constexpr Word lastWordMask(){
+        return Bits%mWordBits==0 ? Word(~Word(0))
+               : Word((Word(1)<<(Bits%mWordBits))-1);
+    }
+};
+
+template <int Bits>
+inline int BitMask<Bits>::getIndex() const {
+    for (int i=mWords-1; i>=0; --i){
+        if (mVal[i])
+            return i*mWordBits+64-__builtin_clzll(mVal[i]);
+    }
+    return 0;
+}
+
+template <int Bits>
+inline int BitMask<Bits>::getLowIndex() const {
+    for (int i=0; i<mWords; ++i){
+        if (mVal[i])
+            return i*mWordBits+__builtin_ctzll(mVal[i])+1;
+    }
+    return 0;
+}
+
+template <int Bits>
+inline int BitMask<Bits>::getBitsNum() const {
+    int counter=0;
+    for (auto el: mVal)
+        counter+=__builtin_popcountll(el);
+    return counter;
+}
+
+template <int Bits>
+inline BitMask<Bits> operator | (BitMask<Bits> x, const BitMask<Bits>& y){
+    return x|=y;
+}
+template <int Bits>
+inline BitMask<Bits> operator & (BitMask<Bits> x, const BitMask<Bits>& y){
+    return x&=y;
+}
+template <int Bits>
+inline BitMask<Bits> operator ^ (BitMask<Bits> x, const BitMask<Bits>& y){
+    return x^=y;
+}
+
+#endif // SUDOKU_BITMASK_H
@@ -0,0 +1,100 @@
+/*
+ * board.h
+ *
+ * Flat sudoku board: one byte per cell, cells row by row,
+ * 0 is an empty cell. Board owns cache-line aligned storage for
+ * the largest supported side, so it never allocates, but clears and
+ * copies only the side*side cells in use; BoardView is a non-owning
+ * pointer to cells of any board.
+ *
+ */
+
+#ifndef SUDOKU_BOARD_H
+#define SUDOKU_BOARD_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+typedef int Cell;
+typedef std::vector<Cell> Row;
+
+// largest supported box side, boards are up to (box*box)x(box*box)
+constexpr int maxBoardBox=8;
+
+class BoardView
+{
+public:
+    BoardView()=default;
+    BoardView(std::uint8_t* cells, int side): mCells(cells), mSide(side){}
+    int side() const {return mSide;}
+    int cellsNum() const {return mSide*mSide;}
+    std::uint8_t* data() const {return mCells;}
+    // board[i][j] is the cell in row i and column j
+    std::uint8_t* operator[](int row) const {return mCells+row*mSide;}
+    // adapters to and from the board of rows, fromRows() returns false
+    // if rows don't fit the view, values out of 0..side are stored
+    // as mBadValue, so that solvers report the offending cell
+    void toRows(std::vector<Row>& rows) const;
+    bool fromRows(const std::vector<Row>& rows) const;
+    static constexpr std::uint8_t mBadValue=0xFF;
+private:
+    std::uint8_t* mCells=nullptr;
+    int mSide=0;
+};
+
+class Board
+{
+public:
+    static constexpr int mMaxSide=maxBoardBox*maxBoardBox;
+    static constexpr int mMaxCells=mMaxSide*mMaxSide;
+    // empty board, side must not exceed mMaxSide
+    explicit Board(int side=9): mSide(side){clear();}
+    Board(const Board& board): mSide(board.mSide){copyCells(board);}
+    Board& operator=(const Board& board){
+        mSide=board.mSide;
+        copyCells(board);
+        return *this;
+    }
+    int side() const {return mSide;}
+    BoardView view() {return BoardView(mCells.data(), mSide);}
+    std::uint8_t* operator[](int row) {return mCells.data()+row*mSide;}
+    const std::uint8_t* operator[](int row) const {
+        return mCells.data()+row*mSide;
+    }
+    void resize(int side){
+        mSide=side;
+        clear();
+    }
+private:
+    // cells past side*side are never read
+    alignas(64) std::array<std::uint8_t, mMaxCells> mCells;
+    int mSide;
+    void clear(){std::fill_n(mCells.begin(), mSide*mSide, 0);}
+    void copyCells(const Board& board){
+        std::copy_n(board.mCells.begin(), mSide*mSide, mCells.begin());
+    }
+};
+
+inline void BoardView::toRows(std::vector<Row>& rows) const {
+    rows.resize(mSide);
+    for (int i=0; i<mSide; ++i)
+        rows[i].assign((*this)[i], (*this)[i]+mSide);
+}
+
+inline bool BoardView::fromRows(const std::vector<Row>& rows) const {
+    if (int(rows.size())!=mSide)
+        return false;
+    for (int i=0; i<mSide; ++i){
+        if (int(rows[i].size())!=mSide)
+            return false;
+        for (int j=0; j<mSide; ++j){
+            int val=rows[i][j];
+            (*this)[i][j]=val<0 || val>mSide ? mBadValue : std::uint8_t(val);
+        }
+    }
+    return true;
+}
+
+#endif // SUDOKU_BOARD_H
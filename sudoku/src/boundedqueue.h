@@ -0,0 +1,81 @@
+/*
+ * boundedqueue.h
+ *
+ * Blocking FIFO queue of limited capacity joining stages of
+ * a pipeline: a full queue stops its producers, so a slow stage
+ * holds back the faster ones instead of letting memory grow.
+ *
+ */
+
+#ifndef SUDOKU_BOUNDEDQUEUE_H
+#define SUDOKU_BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief The BoundedQueue class push() waits for a free place,
+ * pop() waits for an item. After close() push() drops items and
+ * returns false, pop() takes the items left and then returns false,
+ * so consumers finish when the queue is drained.
+ */
+template <class T>
+class BoundedQueue
+{
+public:
+    explicit
+    BoundedQueue(std::size_t capacity): mCapacity(capacity ? capacity : 1){}
+    BoundedQueue(const BoundedQueue& bq)=delete;
+    BoundedQueue& operator=(const BoundedQueue& bq)=delete;
+
+    bool push(T item){
+        std::unique_lock<std::mutex> lck(mMutex);
+        mNotFull.wait(lck, [this]{
+            return mIsClosed || mItems.size()<mCapacity;});
+        if (mIsClosed)
+            return false;
+        mItems.push_back(std::move(item));
+        lck.unlock();
+        mNotEmpty.notify_one();
+        return true;
+    }
+    bool pop(T& item){
+        std::unique_lock<std::mutex> lck(mMutex);
+        mNotEmpty.wait(lck, [this]{return mIsClosed || !mItems.empty();});
+        return takeFront(lck, item);
+    }
+    // doesn't wait, false if the queue is empty
+    bool tryPop(T& item){
+        std::unique_lock<std::mutex> lck(mMutex);
+        return takeFront(lck, item);
+    }
+    void close(){
+        {
+            std::lock_guard<std::mutex> lck(mMutex);
+            mIsClosed=true;
+        }
+        mNotFull.notify_all();
+        mNotEmpty.notify_all();
+    }
+    std::size_t getCapacity() const {return mCapacity;}
+private:
+    std::size_t mCapacity;
+    bool mIsClosed=false;
+    std::deque<T> mItems;
+    std::mutex mMutex;
+    std::condition_variable mNotFull, mNotEmpty;
+
+    bool takeFront(std::unique_lock<std::mutex>& lck, T& item){
+        if (mItems.empty())
+            return false;
+        item=std::move(mItems.front());
+        mItems.pop_front();
+        lck.unlock();
+        mNotFull.notify_one();
+        return true;
+    }
+};
+
+#endif // SUDOKU_BOUNDEDQUEUE_H
@@ -0,0 +1,327 @@
+/* Canonical form of boards
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "canonical.h"
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * Depth first search over images of the board: orientation, then
+ * lines of the image one by one, columns are placed with the first
+ * row, as it needs them. Every image cell is compared with the best
+ * image so far, a branch stops as soon as it is greater. A branch
+ * which becomes smaller overwrites the best image while it goes on,
+ * so the prefix of the current branch is always the prefix of mBest.
+ *
+ * Only images with bands, rows inside bands, stacks and columns
+ * inside stacks sorted by keys are searched. Keys depend only on
+ * things every symmetry keeps (numbers of clues, frequencies of
+ * their digits), so equivalent boards have the same set of such
+ * images and the smallest of them is still canonical, while the
+ * search has to try only lines with equal keys in every position.
+ */
+class Canonizer
+{
+public:
+    Canonizer(BoardView board, int box);
+    // false if the search needs more than nodeLimit nodes
+    bool run(BoardView canonical, BoardTransform& transform,
+             long long nodeLimit);
+private:
+    int mBox, mSide;
+    // mLines[0] is the board, mLines[1] is transposed one
+    std::array<Board, 2> mLines;
+    std::array<std::uint8_t, Board::mMaxCells> mBest;
+    BoardTransform mBestTransform, mTransform;
+    // labels of the image for the board digits, 0 - not met yet
+    std::array<std::uint8_t, Board::mMaxSide+1> mLabels, mBestLabels;
+    int mNextLabel=1, mBestNextLabel=1;
+    // bit k is set for used band, row, stack or column k
+    std::uint64_t mBands=0, mRows=0, mStacks=0, mCols=0;
+    const Board* mBoard=nullptr;
+    long long mNodesLeft=0;
+    // mLineKeys[t][a] - key of line a of mLines[t],
+    // mBandKeys[t][b] - key of band b of mLines[t]
+    using Keys=std::array<std::uint64_t, Board::mMaxSide>;
+    std::array<Keys, 2> mLineKeys, mBandKeys;
+    // keys of rows, bands, columns and stacks of the current orientation
+    const Keys *mRowKeys=nullptr, *mRowBandKeys=nullptr;
+    const Keys *mColKeys=nullptr, *mStackKeys=nullptr;
+
+    void computeKeys();
+    // smallest key of lines first..last-1 not in used
+    static std::uint64_t minKey(const Keys& keys, std::uint64_t used,
+                                int first, int last);
+
+    std::uint8_t label(std::uint8_t val, bool& isNew){
+        isNew=val && !mLabels[val];
+        if (isNew)
+            mLabels[val]=mNextLabel++;
+        return mLabels[val];
+    }
+    void unLabel(std::uint8_t val){
+        mLabels[val]=0;
+        --mNextLabel;
+    }
+    // isLess - the branch is already smaller than mBest,
+    // mBest is overwritten without comparisons
+    void placeRow(int i, bool isLess);
+    void placeColumn(int j, bool isLess);
+    void fillRow(int i, bool isLess);
+};
+
+Canonizer::Canonizer(BoardView board, int box)
+    : mBox(box), mSide(box*box)
+{
+    mLines[0].resize(mSide);
+    mLines[1].resize(mSide);
+    for (int i=0; i<mSide; ++i)
+        for (int j=0; j<mSide; ++j)
+            mLines[0][i][j]=mLines[1][j][i]=board[i][j];
+    mLabels.fill(0);
+    computeKeys();
+}
+
+// order of values doesn't matter
+std::uint64_t hashSorted(std::uint64_t* beg, std::uint64_t* end,
+                         std::uint64_t hash){
+    std::sort(beg, end);
+    for (; beg!=end; ++beg)
+        hash=(hash^*beg)*0x100000001B3ULL;
+    return hash;
+}
+
+void Canonizer::computeKeys(){
+    std::array<int, Board::mMaxSide+1> freq;
+    freq.fill(0);
+    for (int i=0; i<mSide; ++i)
+        for (int j=0; j<mSide; ++j)
+            ++freq[mLines[0][i][j]];
+    freq[0]=0;
+    std::array<std::uint64_t, Board::mMaxSide> parts, boxes;
+    for (int t=0; t<2; ++t){
+        for (int a=0; a<mSide; ++a){
+            // clues in every box of the line and digit frequencies
+            const std::uint8_t* line=mLines[t][a];
+            for (int k=0; k<mBox; ++k){
+                parts[k]=0;
+                for (int b=k*mBox; b<k*mBox+mBox; ++b)
+                    parts[k]+=line[b]!=0;
+            }
+            std::uint64_t hash=hashSorted(parts.data(),
+                                          parts.data()+mBox,
+                                          0xCBF29CE484222325ULL);
+            int cluesNum=0;
+            for (int b=0; b<mSide; ++b)
+                if (line[b])
+                    parts[cluesNum++]=freq[line[b]];
+            mLineKeys[t][a]=hashSorted(parts.data(),
+                                       parts.data()+cluesNum, hash);
+        }
+        for (int band=0; band<mBox; ++band){
+            for (int k=0; k<mBox; ++k){
+                parts[k]=mLineKeys[t][band*mBox+k];
+                boxes[k]=0;
+                for (int a=band*mBox; a<band*mBox+mBox; ++a)
+                    for (int b=k*mBox; b<k*mBox+mBox; ++b)
+                        boxes[k]+=mLines[t][a][b]!=0;
+            }
+            std::uint64_t hash=hashSorted(boxes.data(), boxes.data()+mBox,
+                                          0xCBF29CE484222325ULL);
+            mBandKeys[t][band]=hashSorted(parts.data(),
+                                          parts.data()+mBox, hash);
+        }
+    }
+}
+
+std::uint64_t Canonizer::minKey(const Keys& keys, std::uint64_t used,
+                                int first, int last){
+    std::uint64_t res=~std::uint64_t(0);
+    for (int k=first; k<last; ++k)
+        if (!((used>>k)&1) && keys[k]<res)
+            res=keys[k];
+    return res;
+}
+
+bool Canonizer::run(BoardView canonical, BoardTransform& transform,
+                    long long nodeLimit){
+    mNodesLeft=nodeLimit;
+    bool isLess=true; // nothing to compare with yet
+    for (int t=0; t<2; ++t){
+        mBoard=&mLines[t];
+        mTransform.mIsTransposed=t;
+        mRowKeys=&mLineKeys[t];
+        mRowBandKeys=&mBandKeys[t];
+        mColKeys=&mLineKeys[1-t];
+        mStackKeys=&mBandKeys[1-t];
+        placeRow(0, isLess);
+        isLess=false;
+    }
+    if (mNodesLeft<0)
+        return false;
+    for (int i=0; i<mSide; ++i)
+        for (int j=0; j<mSide; ++j)
+            canonical[i][j]=mBest[i*mSide+j];
+    // digits which are not on the board take the rest of labels
+    transform=mBestTransform;
+    transform.mDigits[0]=0;
+    for (int val=1, next=mBestNextLabel; val<=mSide; ++val)
+        transform.mDigits[val]=mBestLabels[val] ? mBestLabels[val]
+                                                : next++;
+    return true;
+}
+
+void Canonizer::placeRow(int i, bool isLess){
+    if (--mNodesLeft<0)
+        return;
+    if (i==mSide){
+        if (isLess){
+            mBestTransform=mTransform;
+            mBestLabels=mLabels;
+            mBestNextLabel=mNextLabel;
+        }
+        return;
+    }
+    int firstBand=0, lastBand=mBox;
+    std::uint64_t bandKey=minKey(*mRowBandKeys, mBands, 0, mBox);
+    if (i%mBox){
+        // the band of the previous row
+        firstBand=mTransform.mRows[i-1]/mBox;
+        lastBand=firstBand+1;
+        bandKey=(*mRowBandKeys)[firstBand];
+    }
+    for (int band=firstBand; band<lastBand; ++band){
+        if ((*mRowBandKeys)[band]!=bandKey
+                || (i%mBox==0 && (mBands>>band)&1))
+            continue;
+        mBands|=std::uint64_t(1)<<band;
+        std::uint64_t rowKey=minKey(*mRowKeys, mRows, band*mBox,
+                                    band*mBox+mBox);
+        for (int row=band*mBox; row<band*mBox+mBox; ++row){
+            if ((*mRowKeys)[row]!=rowKey || (mRows>>row)&1)
+                continue;
+            mRows|=std::uint64_t(1)<<row;
+            mTransform.mRows[i]=row;
+            if (i==0)
+                placeColumn(0, isLess);
+            else
+                fillRow(i, isLess);
+            // the best image is complete after the first branch
+            isLess=false;
+            mRows&=~(std::uint64_t(1)<<row);
+        }
+        if (i%mBox==0)
+            mBands&=~(std::uint64_t(1)<<band);
+    }
+}
+
+void Canonizer::placeColumn(int j, bool isLess){
+    if (--mNodesLeft<0)
+        return;
+    if (j==mSide){
+        placeRow(1, isLess);
+        return;
+    }
+    const std::uint8_t* line=(*mBoard)[mTransform.mRows[0]];
+    int firstStack=0, lastStack=mBox;
+    std::uint64_t stackKey=minKey(*mStackKeys, mStacks, 0, mBox);
+    if (j%mBox){
+        firstStack=mTransform.mCols[j-1]/mBox;
+        lastStack=firstStack+1;
+        stackKey=(*mStackKeys)[firstStack];
+    }
+    for (int stack=firstStack; stack<lastStack; ++stack){
+        if ((*mStackKeys)[stack]!=stackKey
+                || (j%mBox==0 && (mStacks>>stack)&1))
+            continue;
+        mStacks|=std::uint64_t(1)<<stack;
+        std::uint64_t colKey=minKey(*mColKeys, mCols, stack*mBox,
+                                    stack*mBox+mBox);
+        for (int col=stack*mBox; col<stack*mBox+mBox; ++col){
+            if ((*mColKeys)[col]!=colKey || (mCols>>col)&1)
+                continue;
+            bool isNew;
+            std::uint8_t val=label(line[col], isNew);
+            bool isBranchLess=isLess || val<mBest[j];
+            if (isBranchLess || val==mBest[j]){
+                mCols|=std::uint64_t(1)<<col;
+                mTransform.mCols[j]=col;
+                mBest[j]=val;
+                placeColumn(j+1, isBranchLess);
+                isLess=false;
+                mCols&=~(std::uint64_t(1)<<col);
+            }
+            if (isNew)
+                unLabel(line[col]);
+        }
+        if (j%mBox==0)
+            mStacks&=~(std::uint64_t(1)<<stack);
+    }
+}
+
+void Canonizer::fillRow(int i, bool isLess){
+    const std::uint8_t* line=(*mBoard)[mTransform.mRows[i]];
+    std::uint8_t* best=&mBest[i*mSide];
+    std::array<std::uint8_t, Board::mMaxSide> added;
+    int addedNum=0;
+    bool isGreater=false;
+    for (int j=0; j<mSide; ++j){
+        bool isNew;
+        std::uint8_t cell=line[mTransform.mCols[j]];
+        std::uint8_t val=label(cell, isNew);
+        if (isNew)
+            added[addedNum++]=cell;
+        if (!isLess){
+            if (val>best[j]){
+                isGreater=true;
+                break;
+            }
+            isLess=val<best[j];
+        }
+        best[j]=val;
+    }
+    if (!isGreater)
+        placeRow(i+1, isLess);
+    while (addedNum)
+        unLabel(added[--addedNum]);
+}
+
+} // namespace
+
+void BoardTransform::apply(BoardView from, BoardView to) const {
+    int side=from.side();
+    for (int i=0; i<side; ++i)
+        for (int j=0; j<side; ++j)
+            to[i][j]=mDigits[mIsTransposed ? from[mCols[j]][mRows[i]]
+                                           : from[mRows[i]][mCols[j]]];
+}
+
+void BoardTransform::applyInverse(BoardView from, BoardView to) const {
+    int side=from.side();
+    std::array<std::uint8_t, Board::mMaxSide+1> digits;
+    for (int val=0; val<=side; ++val)
+        digits[mDigits[val]]=val;
+    for (int i=0; i<side; ++i)
+        for (int j=0; j<side; ++j){
+            std::uint8_t& cell=mIsTransposed ? to[mCols[j]][mRows[i]]
+                                             : to[mRows[i]][mCols[j]];
+            cell=digits[from[i][j]];
+        }
+}
+
+bool canonicalize(BoardView board, Board& canonical,
+                  BoardTransform& transform, long long nodeLimit){
+    int side=board.side(), box=1;
+    while (box*box<side)
+        ++box;
+    if (side<1 || box*box!=side || side>Board::mMaxSide)
+        return false;
+    for (int cell=0; cell<board.cellsNum(); ++cell)
+        if (board.data()[cell]>side)
+            return false;
+    canonical.resize(side);
+    return Canonizer(board, box).run(canonical.view(), transform,
+                                     nodeLimit);
+}
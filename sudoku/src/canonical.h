@@ -0,0 +1,50 @@
+/*
+ * canonical.h
+ *
+ * Symmetries of sudoku boards: transposition, permutations of bands
+ * and of rows inside bands, the same for stacks and columns, and
+ * relabelling of digits. Equivalent boards have the same canonical
+ * form, the lexicographically smallest board of all their images
+ * with digits numbered in order of first appearance.
+ *
+ */
+
+#ifndef SUDOKU_CANONICAL_H
+#define SUDOKU_CANONICAL_H
+
+#include <array>
+#include <cstdint>
+
+#include "board.h"
+
+/**
+ * Row i of the image is line mRows[i] of the board (column mRows[i]
+ * if mIsTransposed), its cell j is taken from line mCols[j] the other
+ * way, every value v becomes mDigits[v] (0 stays 0).
+ */
+struct BoardTransform
+{
+    bool mIsTransposed=false;
+    std::array<std::uint8_t, Board::mMaxSide> mRows, mCols;
+    std::array<std::uint8_t, Board::mMaxSide+1> mDigits;
+
+    // image of from goes to to, boards must have the same side
+    void apply(BoardView from, BoardView to) const;
+    // back from the image: to gets the board whose image is from
+    void applyInverse(BoardView from, BoardView to) const;
+};
+
+/**
+ * @brief canonicalize Finds the canonical form of board and the
+ * transform giving it. Transform maps every digit, also digits which
+ * are not on the board, so it maps solutions as well.
+ * Boards with many symmetries (an empty board is the worst) have many
+ * equal branches, the search gives up after nodeLimit nodes.
+ * Generated and collected puzzles need less than 256 nodes.
+ * @return false if board side is not a square, a value is out
+ * of range or the search needs more than nodeLimit nodes.
+ */
+bool canonicalize(BoardView board, Board& canonical,
+                  BoardTransform& transform, long long nodeLimit=1<<16);
+
+#endif // SUDOKU_CANONICAL_H
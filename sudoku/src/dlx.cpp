@@ -0,0 +1,184 @@
+/* Dancing Links exact cover solver
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "dlx.h"
+
+#include <new>
+
+DancingLinks::DancingLinks(int colNum, int nodesHint)
+    : mColSize(colNum+1, 0)
+{
+    mNodes.reserve(colNum+1+nodesHint);
+    for (int i=0; i<=colNum; ++i){
+        mNodes.push_back(Node{i-1, i+1, i, i, i, -1});
+    }
+    mNodes[0].left=colNum;
+    mNodes[colNum].right=0;
+}
+
+void DancingLinks::addRow(int rowId, const int* cols, int num){
+    int first=mNodes.size();
+    for (int k=0; k<num; ++k){
+        int col=cols[k]+1, ind=mNodes.size();
+        mNodes.push_back(Node{ind-1, ind+1, mNodes[col].up, col, col, rowId});
+        mNodes[mNodes[col].up].down=ind;
+        mNodes[col].up=ind;
+        ++mColSize[col];
+    }
+    mNodes[first].left=mNodes.size()-1;
+    mNodes.back().right=first;
+}
+
+inline void DancingLinks::cover(int col){
+    mNodes[mNodes[col].right].left=mNodes[col].left;
+    mNodes[mNodes[col].left].right=mNodes[col].right;
+    for (int i=mNodes[col].down; i!=col; i=mNodes[i].down){
+        for (int j=mNodes[i].right; j!=i; j=mNodes[j].right){
+            mNodes[mNodes[j].down].up=mNodes[j].up;
+            mNodes[mNodes[j].up].down=mNodes[j].down;
+            --mColSize[mNodes[j].column];
+        }
+    }
+}
+
+inline void DancingLinks::uncover(int col){
+    for (int i=mNodes[col].up; i!=col; i=mNodes[i].up){
+        for (int j=mNodes[i].left; j!=i; j=mNodes[j].left){
+            ++mColSize[mNodes[j].column];
+            mNodes[mNodes[j].down].up=j;
+            mNodes[mNodes[j].up].down=j;
+        }
+    }
+    mNodes[mNodes[col].right].left=col;
+    mNodes[mNodes[col].left].right=col;
+}
+
+bool DancingLinks::searchLevel(){
+    if (mNodes[0].right==0)
+        return true;
+    ++mNodesNum;
+    // column with the fewest rows left
+    int col=mNodes[0].right;
+    for (int c=mNodes[col].right; c!=0; c=mNodes[c].right)
+        if (mColSize[c]<mColSize[col])
+            col=c;
+    if (mColSize[col]==0)
+        return false;
+    cover(col);
+    for (int i=mNodes[col].down; i!=col; i=mNodes[i].down){
+        mPartial.push_back(mNodes[i].rowId);
+        for (int j=mNodes[i].right; j!=i; j=mNodes[j].right)
+            cover(mNodes[j].column);
+        if (searchLevel())
+            return true; // matrix is left as is, it is not used anymore
+        for (int j=mNodes[i].left; j!=i; j=mNodes[j].left)
+            uncover(mNodes[j].column);
+        mPartial.pop_back();
+    }
+    uncover(col);
+    return false;
+}
+
+bool DancingLinks::search(std::vector<int>& solution){
+    mPartial.clear();
+    if (!searchLevel())
+        return false;
+    solution=mPartial;
+    return true;
+}
+
+namespace {
+
+SolveResult solveCover(BoardView board, long long* nodesNum){
+    SolveResult result;
+    int side=board.side(), box=1;
+    while (box*box<side)
+        ++box;
+    if (box*box!=side || side>Board::mMaxSide){
+        result.mStatus=SolveStatus::ImproperSize;
+        return result;
+    }
+    int area=side*side;
+    // columns: cell filled, digit in row, digit in column, digit in box
+    std::vector<char> used(3*area, 0);
+    for (int i=0; i<side; ++i){
+        for (int j=0, val; j<side; ++j){
+            if ((val=board[i][j])==0)
+                continue;
+            int b=(i/box)*box+j/box;
+            if (val>side || used[i*side+val-1] || used[area+j*side+val-1]
+                    || used[2*area+b*side+val-1]){
+                result.mStatus=SolveStatus::ImproperClue;
+                result.mRow=i;
+                result.mCol=j;
+                return result;
+            }
+            used[i*side+val-1]=used[area+j*side+val-1]=
+                used[2*area+b*side+val-1]=1;
+        }
+    }
+    DancingLinks dlx(4*area, 4*area*side);
+    int cols[4];
+    for (int i=0; i<side; ++i){
+        for (int j=0; j<side; ++j){
+            int b=(i/box)*box+j/box;
+            for (int val=1; val<=side; ++val){
+                if (board[i][j] ? board[i][j]!=val
+                    : (used[i*side+val-1] || used[area+j*side+val-1] ||
+                       used[2*area+b*side+val-1]))
+                    continue;
+                cols[0]=i*side+j;
+                cols[1]=area+i*side+val-1;
+                cols[2]=2*area+j*side+val-1;
+                cols[3]=3*area+b*side+val-1;
+                dlx.addRow((i*side+j)*side+val-1, cols, 4);
+            }
+        }
+    }
+    std::vector<int> solution;
+    bool isSolved=dlx.search(solution);
+    if (nodesNum)
+        *nodesNum=dlx.getNodesNum();
+    if (!isSolved)
+        return result;
+    for (int rowId: solution)
+        board[rowId/side/side][rowId/side%side]=rowId%side+1;
+    result.mStatus=SolveStatus::Solved;
+    return result;
+}
+
+} // namespace
+
+SolveResult trySolveDancingLinks(BoardView board,
+                                 long long* nodesNum) noexcept {
+    try {
+        return solveCover(board, nodesNum);
+    } catch (std::bad_alloc&) {
+        // no memory for the matrix, the board is unchanged
+        SolveResult result;
+        result.mStatus=SolveStatus::Aborted;
+        return result;
+    }
+}
+
+bool solveDancingLinks(BoardView board, long long* nodesNum){
+    SolveResult result=trySolveDancingLinks(board, nodesNum);
+    if (result.mStatus==SolveStatus::ImproperSize)
+        throw BadInitTableSizeException();
+    if (result.mStatus==SolveStatus::ImproperClue)
+        throw ImproperAssignmentException(result.mRow, result.mCol);
+    return result.isSolved();
+}
+
+bool solveDancingLinks(std::vector<Row>& board, long long* nodesNum){
+    Board flat(0);
+    if (int(board.size())>Board::mMaxSide)
+        throw BadInitTableSizeException();
+    flat.resize(board.size());
+    if (!flat.view().fromRows(board))
+        throw BadInitTableSizeException();
+    bool isSolved=solveDancingLinks(flat.view(), nodesNum);
+    if (isSolved)
+        flat.view().toRows(board);
+    return isSolved;
+}
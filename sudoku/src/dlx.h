@@ -0,0 +1,57 @@
+/*
+ * dlx.h
+ *
+ * Exact cover solver (Knuth's Algorithm X with Dancing Links)
+ * and sudoku reduction to it.
+ * All nodes live in one flat array and are linked by indices,
+ * so the whole matrix is a single allocation.
+ *
+ */
+
+#ifndef SUDOKU_DLX_H
+#define SUDOKU_DLX_H
+
+#include <vector>
+
+#include "sudoku.h"
+
+class DancingLinks
+{
+public:
+    explicit DancingLinks(int colNum, int nodesHint=0);
+    // adds row with given id, which covers columns cols[0..num)
+    void addRow(int rowId, const int* cols, int num);
+    // searches for the first exact cover, solution gets ids of its rows
+    bool search(std::vector<int>& solution);
+    long long getNodesNum() const {return mNodesNum;}
+private:
+    struct Node{
+        int left, right, up, down, column, rowId;
+    };
+    // node 0 is the root, nodes 1..colNum are column headers
+    std::vector<Node> mNodes;
+    std::vector<int> mColSize;
+    std::vector<int> mPartial;
+    long long mNodesNum=0;
+
+    void cover(int col);
+    void uncover(int col);
+    bool searchLevel();
+};
+
+/**
+ * @brief trySolveDancingLinks Solves board of any supported size in place.
+ * @param nodesNum If not null gets number of search nodes.
+ * @return ImproperClue if clues contradict each other, Aborted if there
+ * is no memory for the matrix, board is left unchanged unless it is
+ * solved.
+ */
+SolveResult trySolveDancingLinks(BoardView board,
+                                 long long* nodesNum=nullptr) noexcept;
+// same, returns false if there is no solution, throws
+// ImproperAssignmentException and BadInitTableSizeException
+bool solveDancingLinks(BoardView board, long long* nodesNum=nullptr);
+// adapter for boards of rows, also throws BadInitTableSizeException
+bool solveDancingLinks(std::vector<Row>& board, long long* nodesNum=nullptr);
+
+#endif // SUDOKU_DLX_H
@@ -0,0 +1,198 @@
+/* Puzzle generator implementation
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "generator.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "sudoku.h"
+#include "workstealing.h"
+
+namespace {
+
+// splitmix64: small, fast and the same everywhere, unlike
+// distributions of the standard library
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed): mState(seed){}
+    static std::uint64_t mix(std::uint64_t z){
+        z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+        z=(z^(z>>27))*0x94D049BB133111EBULL;
+        return z^(z>>31);
+    }
+    std::uint64_t next(){return mix(mState+=0x9E3779B97F4A7C15ULL);}
+    // uniform in 0..n-1
+    int below(int n){
+        return int(((next()>>32)*std::uint64_t(n))>>32);
+    }
+    template <typename T>
+    void shuffle(T* arr, int n){
+        for (int i=n-1; i>0; --i)
+            std::swap(arr[i], arr[below(i+1)]);
+    }
+private:
+    std::uint64_t mState;
+};
+
+// rows (or columns) in random order of bands and random order
+// inside every band, so the grid stays valid
+void bandPermutation(Random& rng, int box,
+                     std::array<int, Board::mMaxSide>& perm){
+    std::array<int, maxBoardBox> bands, lines;
+    std::iota(bands.begin(), bands.begin()+box, 0);
+    rng.shuffle(bands.data(), box);
+    for (int b=0; b<box; ++b){
+        std::iota(lines.begin(), lines.begin()+box, 0);
+        rng.shuffle(lines.data(), box);
+        for (int k=0; k<box; ++k)
+            perm[b*box+k]=bands[b]*box+lines[k];
+    }
+}
+
+bool isCompleted(Board& board, long long nodeLimit){
+    Table table(board.view());
+    table.setNodeLimit(nodeLimit);
+    return table.trySolve().isSolved();
+}
+
+void randomGrid(Random& rng, int box, long long nodeLimit, Board& grid){
+    int side=box*box;
+    Board seeded(side);
+    std::array<std::uint8_t, Board::mMaxSide> vals;
+    do {
+        // boxes on the diagonal share no units, so any values fit,
+        // the solver completes the rest (or finds out that it can't
+        // for small boards)
+        seeded.resize(side);
+        for (int b=0; b<box; ++b){
+            std::iota(vals.begin(), vals.begin()+side, 1);
+            rng.shuffle(vals.data(), side);
+            for (int k=0; k<side; ++k)
+                seeded[b*box+k/box][b*box+k%box]=vals[k];
+        }
+    } while (!isCompleted(seeded, nodeLimit));
+    // the solver fills cells in a fixed order, mixing lines
+    // hides it
+    std::array<int, Board::mMaxSide> rows, cols;
+    bandPermutation(rng, box, rows);
+    bandPermutation(rng, box, cols);
+    grid.resize(side);
+    for (int i=0; i<side; ++i)
+        for (int j=0; j<side; ++j)
+            grid[i][j]=seeded[rows[i]][cols[j]];
+}
+
+// bit val-1 for value val, empty cells have no bit; values go up to
+// 64, so a shift by val would be undefined for the largest boards
+std::uint64_t valueBit(int val){
+    return val ? std::uint64_t(1)<<(val-1) : 0;
+}
+
+bool isForced(const Board& puzzle, int box, int cell, int val){
+    int side=box*box, row=cell/side, col=cell%side;
+    int boxRow=row-row%box, boxCol=col-col%box;
+    std::uint64_t seen=0;
+    for (int k=0; k<side; ++k){
+        seen|=valueBit(puzzle[row][k]);
+        seen|=valueBit(puzzle[k][col]);
+        seen|=valueBit(puzzle[boxRow+k/box][boxCol+k%box]);
+    }
+    std::uint64_t all=side==64 ? ~std::uint64_t(0)
+                               : (std::uint64_t(1)<<side)-1;
+    return (seen|valueBit(val))==all;
+}
+
+// propagation solves the puzzle, so its solution is unique too
+bool isDeduced(const Board& puzzle, const Deductions& deductions){
+    Board board=puzzle;
+    Table table(board.view());
+    table.setDeductions(deductions);
+    return table.solveWithoutGuessing();
+}
+
+// a puzzle the search can't finish within the limit is not unique
+bool isUnique(Board& puzzle, long long nodeLimit){
+    Table table(puzzle.view());
+    table.setNodeLimit(nodeLimit);
+    return table.countSolutions(2)==1 && !table.isAborted();
+}
+
+} // namespace
+
+PuzzleGenerator::PuzzleGenerator(const GeneratorOptions& options)
+    : mOptions(options), mSide(options.mBox*options.mBox)
+{
+    if (mOptions.mBox<1 || mOptions.mBox>maxBoardBox)
+        throw BadInitTableSizeException();
+}
+
+bool PuzzleGenerator::isRemovable(Board& puzzle) const {
+    switch (mOptions.mDifficulty){
+    case Difficulty::Easy:
+        return isDeduced(puzzle, Deductions());
+    case Difficulty::Medium:
+        return isDeduced(puzzle, Deductions::all());
+    default:
+        return isUnique(puzzle, mOptions.mNodeLimit);
+    }
+}
+
+bool PuzzleGenerator::generate(std::uint64_t ind, Board& puzzle) const {
+    // streams of neighbouring indices must not overlap,
+    // so the state is a hash of both seed and index
+    Random rng(Random::mix(Random::mix(mOptions.mSeed)+ind));
+    int cellsNum=mSide*mSide;
+    std::array<int, Board::mMaxCells> order;
+    for (int attempt=0; attempt<mOptions.mAttempts; ++attempt){
+        randomGrid(rng, mOptions.mBox, mOptions.mNodeLimit, puzzle);
+        std::uint8_t* cells=puzzle.view().data();
+        std::iota(order.begin(), order.begin()+cellsNum, 0);
+        rng.shuffle(order.data(), cellsNum);
+        int clues=cellsNum;
+        for (int k=0; k<cellsNum && clues>mOptions.mClues; ++k){
+            int cell=order[k];
+            std::uint8_t val=cells[cell];
+            cells[cell]=0;
+            // a clue which other clues of its units force
+            // is redundant, the puzzle doesn't change
+            if (isForced(puzzle, mOptions.mBox, cell, val)
+                    || isRemovable(puzzle))
+                --clues;
+            else
+                cells[cell]=val;
+        }
+        if (mOptions.mClues && clues!=mOptions.mClues)
+            continue;
+        if (mOptions.mDifficulty==Difficulty::Medium
+                && isDeduced(puzzle, Deductions()))
+            continue;
+        if (mOptions.mDifficulty==Difficulty::Hard
+                && isDeduced(puzzle, Deductions::all()))
+            continue;
+        return true;
+    }
+    return false;
+}
+
+std::vector<Board> PuzzleGenerator::generateBatch(std::uint64_t first,
+                                                  std::size_t count) const {
+    std::vector<Board> puzzles(count, Board(mSide));
+    std::vector<char> isDone(count, 0);
+    {
+        WorkStealingPool pool(mOptions.mThreadsNum);
+        for (std::size_t i=0; i<count; ++i)
+            pool.submit([this, first, i, &puzzles, &isDone]{
+                isDone[i]=generate(first+i, puzzles[i]);
+            });
+        pool.wait();
+    }
+    std::size_t kept=0;
+    for (std::size_t i=0; i<count; ++i)
+        if (isDone[i])
+            puzzles[kept++]=puzzles[i];
+    puzzles.erase(puzzles.begin()+kept, puzzles.end());
+    return puzzles;
+}
@@ -0,0 +1,67 @@
+/*
+ * generator.h
+ *
+ * Puzzle generator: random solved grid, then clues are removed in
+ * random order while the puzzle keeps exactly one solution.
+ * Every puzzle is produced from its own random stream derived from
+ * the seed and the puzzle index, so output doesn't depend on the
+ * number of threads and is the same on every platform.
+ *
+ */
+
+#ifndef SUDOKU_GENERATOR_H
+#define SUDOKU_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+
+/**
+ * Easy - naked and hidden singles solve the puzzle,
+ * Medium - needs Deductions::all(), but no guesses,
+ * Hard - needs guesses even with all deductions,
+ * Any - only uniqueness of the solution is checked.
+ */
+enum class Difficulty {Any, Easy, Medium, Hard};
+
+struct GeneratorOptions
+{
+    // box side, board side is mBox*mBox
+    int mBox=3;
+    // clues to leave, 0 - remove while the solution stays unique
+    // (minimal puzzle). Targets below the usual minimal puzzle
+    // (about 22-25 clues for 9x9) are reached rarely.
+    int mClues=0;
+    Difficulty mDifficulty=Difficulty::Any;
+    std::uint64_t mSeed=1;
+    // grids tried for one puzzle before it is given up
+    int mAttempts=100;
+    // search nodes for one uniqueness check, a clue stays if
+    // the check needs more (see Table::setNodeLimit())
+    long long mNodeLimit=10000;
+    // threads of generateBatch(), 0 - all cores
+    int mThreadsNum=0;
+};
+
+class PuzzleGenerator
+{
+public:
+    // throws BadInitTableSizeException for unsupported mBox
+    explicit PuzzleGenerator(const GeneratorOptions& options);
+    // puzzle number ind of the seed, false if no grid of mAttempts
+    // gives a puzzle with the wanted clues and difficulty
+    bool generate(std::uint64_t ind, Board& puzzle) const;
+    // puzzles first..first+count-1 generated in parallel, in index
+    // order, without the failed ones. Different indices can give
+    // the same puzzle, which is likely only for small boards.
+    std::vector<Board> generateBatch(std::uint64_t first,
+                                     std::size_t count) const;
+private:
+    GeneratorOptions mOptions;
+    int mSide;
+    // puzzle without removed clues still fits the options
+    bool isRemovable(Board& puzzle) const;
+};
+
+#endif // SUDOKU_GENERATOR_H
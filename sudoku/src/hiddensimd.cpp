@@ -0,0 +1,118 @@
+/* Hidden singles kernel with run time dispatch
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "hiddensimd.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUDOKU_HIDDEN_X86
+#endif
+
+namespace {
+
+typedef void (*HiddenKernel)(const unsigned char*, int, int,
+                             unsigned char*, unsigned char*);
+
+// every cell position: twice|=once&lanes; once|=lanes,
+// units found exactly once are once&~twice
+void hiddenScalar(const unsigned char* lanes, int rowBytes, int cellsNum,
+                  unsigned char* once, unsigned char* seen){
+    int block=0;
+    for (; block+8<=rowBytes; block+=8){
+        std::uint64_t one=0, two=0, val;
+        for (int k=0; k<cellsNum; ++k){
+            std::memcpy(&val, lanes+k*rowBytes+block, 8);
+            two|=one&val;
+            one|=val;
+        }
+        val=one&~two;
+        std::memcpy(once+block, &val, 8);
+        std::memcpy(seen+block, &one, 8);
+    }
+    for (; block<rowBytes; ++block){
+        unsigned char one=0, two=0, val;
+        for (int k=0; k<cellsNum; ++k){
+            val=lanes[k*rowBytes+block];
+            two|=one&val;
+            one|=val;
+        }
+        once[block]=one&~two;
+        seen[block]=one;
+    }
+}
+
+#ifdef SUDOKU_HIDDEN_X86
+// vectors are not split, the last one may read and write past rowBytes
+__attribute__((target("sse2")))
+void hiddenSse2(const unsigned char* lanes, int rowBytes, int cellsNum,
+                unsigned char* once, unsigned char* seen){
+    for (int block=0; block<rowBytes; block+=16){
+        __m128i one=_mm_setzero_si128(), two=one, val;
+        for (int k=0; k<cellsNum; ++k){
+            val=_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                                    lanes+k*rowBytes+block));
+            two=_mm_or_si128(two, _mm_and_si128(one, val));
+            one=_mm_or_si128(one, val);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(once+block),
+                         _mm_andnot_si128(two, one));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(seen+block), one);
+    }
+}
+
+__attribute__((target("avx2")))
+void hiddenAvx2(const unsigned char* lanes, int rowBytes, int cellsNum,
+                unsigned char* once, unsigned char* seen){
+    for (int block=0; block<rowBytes; block+=32){
+        __m256i one=_mm256_setzero_si256(), two=one, val;
+        for (int k=0; k<cellsNum; ++k){
+            val=_mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                                       lanes+k*rowBytes+block));
+            two=_mm256_or_si256(two, _mm256_and_si256(one, val));
+            one=_mm256_or_si256(one, val);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(once+block),
+                            _mm256_andnot_si256(two, one));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(seen+block), one);
+    }
+}
+#endif
+
+struct HiddenDispatch{
+    HiddenDispatch(){
+        mKernel=hiddenScalar;
+        mIsa="scalar";
+#ifdef SUDOKU_HIDDEN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")){
+            mKernel=hiddenAvx2;
+            mIsa="avx2";
+        } else if (__builtin_cpu_supports("sse2")){
+            mKernel=hiddenSse2;
+            mIsa="sse2";
+        }
+#endif
+    }
+    HiddenKernel mKernel;
+    const char* mIsa;
+};
+
+const HiddenDispatch& dispatch(){
+    static const HiddenDispatch disp;
+    return disp;
+}
+
+} // namespace
+
+void hiddenSinglesBytes(const void* lanes, int rowBytes, int cellsNum,
+                        void* once, void* seen){
+    dispatch().mKernel(static_cast<const unsigned char*>(lanes), rowBytes,
+                       cellsNum, static_cast<unsigned char*>(once),
+                       static_cast<unsigned char*>(seen));
+}
+
+const char* hiddenSinglesIsa(){
+    return dispatch().mIsa;
+}
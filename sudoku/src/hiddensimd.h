@@ -0,0 +1,41 @@
+/*
+ * hiddensimd.h
+ *
+ * Hidden singles kernel: for all units of one kind (all rows, all
+ * columns or all boxes) at once finds values which are candidates
+ * of exactly one cell of the unit. Candidates of k-th cell of unit u
+ * are lanes[k*unitsNum+u], so every unit is a SIMD lane of the Word
+ * width: 16 bits for 9x9 and 16x16 boards, 32 bits for 25x25 and
+ * 64 bits for 36x36 up to 64x64.
+ * Implementation is picked at run time: AVX2, SSE2 or scalar.
+ *
+ */
+
+#ifndef SUDOKU_HIDDENSIMD_H
+#define SUDOKU_HIDDENSIMD_H
+
+#include <cstdint>
+
+// lanes, once and seen arrays must have at least this number of
+// readable/writable bytes after their end (vectors are not split)
+constexpr int hiddenKernelPad=32;
+
+/**
+ * @brief hiddenSinglesBytes Byte level kernel, rowBytes is size of all
+ * lanes of one cell position (unitsNum*sizeof(Word)).
+ * once gets bits set in exactly one of cellsNum rows, seen - in any.
+ */
+void hiddenSinglesBytes(const void* lanes, int rowBytes, int cellsNum,
+                        void* once, void* seen);
+
+// name of the implementation picked at run time: "avx2", "sse2", "scalar"
+const char* hiddenSinglesIsa();
+
+template <typename Word>
+inline void hiddenSinglesKernel(const Word* lanes, int unitsNum,
+                                int cellsNum, Word* once, Word* seen){
+    hiddenSinglesBytes(lanes, unitsNum*int(sizeof(Word)), cellsNum,
+                       once, seen);
+}
+
+#endif // SUDOKU_HIDDENSIMD_H
@@ -0,0 +1,231 @@
+/* Lockstep propagation of 9x9 boards, a board per SIMD lane
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "lockstep.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SUDOKU_LOCKSTEP_X86
+#endif
+
+namespace {
+
+constexpr int side=9, box=3, cellsNum=side*side, unitsNum=3*side;
+constexpr std::uint16_t allValues=(1<<side)-1;
+
+// candidates of a cell of all boards of a batch, bit v-1 for value v;
+// the kernel is written with generic vectors, so the same code is
+// compiled for every instruction set
+typedef std::uint16_t Lanes8 __attribute__((vector_size(16)));
+typedef std::uint16_t Lanes16 __attribute__((vector_size(32)));
+
+// rows, columns and boxes: cells of every unit, units of every cell
+struct Units{
+    Units(){
+        for (int i=0; i<side; ++i)
+            for (int j=0; j<side; ++j){
+                int cell=i*side+j, b=(i/box)*box+j/box;
+                int place=(i%box)*box+j%box;
+                mCells[i][j]=cell;
+                mCells[side+j][i]=cell;
+                mCells[2*side+b][place]=cell;
+                mOfCell[cell]={{std::uint8_t(i), std::uint8_t(side+j),
+                                std::uint8_t(2*side+b)}};
+            }
+    }
+    std::array<std::array<std::uint8_t, side>, unitsNum> mCells;
+    std::array<std::array<std::uint8_t, 3>, cellsNum> mOfCell;
+};
+
+const Units& units(){
+    static const Units un;
+    return un;
+}
+
+enum class LaneState {Solved, Open, Bad};
+
+// naked and hidden singles until nothing changes, lanes of bad get
+// all ones on a contradiction. Candidates only shrink, so it stops.
+template <typename V, int Lanes>
+void propagateLanes(V* cand, V& bad){
+    const Units& un=units();
+    const V zero=V{}, all=zero+allValues;
+    V placed[unitsNum];
+    while (true){
+        V changed=zero;
+        // values of solved cells of every unit
+        for (int u=0; u<unitsNum; ++u){
+            V once=zero, twice=zero;
+            for (int cell: un.mCells[u]){
+                V val=cand[cell];
+                V single=V((val&(val-1))==zero)&val;
+                twice|=once&single;
+                once|=single;
+            }
+            placed[u]=once;
+            bad|=V(twice!=zero);
+        }
+        for (int cell=0; cell<cellsNum; ++cell){
+            V val=cand[cell];
+            const auto& of=un.mOfCell[cell];
+            V others=(placed[of[0]]|placed[of[1]]|placed[of[2]])&
+                    ~V((val&(val-1))==zero);
+            V next=val&~others;
+            changed|=next^val;
+            bad|=V(next==zero);
+            cand[cell]=next;
+        }
+        // values with the only place in a unit
+        for (int u=0; u<unitsNum; ++u){
+            V once=zero, twice=zero;
+            for (int cell: un.mCells[u]){
+                twice|=once&cand[cell];
+                once|=cand[cell];
+            }
+            bad|=V(once!=all);
+            V only=once&~twice;
+            for (int cell: un.mCells[u]){
+                V val=cand[cell], hidden=val&only;
+                V isHidden=V(hidden!=zero);
+                bad|=isHidden&V((hidden&(hidden-1))!=zero);
+                V next=(hidden&isHidden)|(val&~isHidden);
+                changed|=next^val;
+                cand[cell]=next;
+            }
+        }
+        changed&=~bad;
+        bool isChanged=false;
+        for (int k=0; k<Lanes; ++k)
+            isChanged|=changed[k]!=0;
+        if (!isChanged)
+            return;
+    }
+}
+
+// boards[0..count) (count<=Lanes) are propagated, cells found are
+// written to boards which are not Bad, boards which are Bad are intact
+template <typename V, int Lanes>
+void propagateBoards(const BoardView* boards, int count, LaneState* states){
+    V cand[cellsNum];
+    V bad=V{};
+    for (int cell=0; cell<cellsNum; ++cell){
+        for (int k=0; k<Lanes; ++k){
+            // unused lanes and values out of range are empty cells,
+            // so they are Bad at once
+            int val=k<count ? boards[k].data()[cell] : -1;
+            cand[cell][k]=val==0 ? allValues :
+                                   val>0 && val<=side ? 1<<(val-1) : 0;
+        }
+    }
+    propagateLanes<V, Lanes>(cand, bad);
+    for (int k=0; k<count; ++k){
+        if (bad[k]){
+            states[k]=LaneState::Bad;
+            continue;
+        }
+        states[k]=LaneState::Solved;
+        std::uint8_t* cells=boards[k].data();
+        for (int cell=0; cell<cellsNum; ++cell){
+            unsigned val=cand[cell][k];
+            if (val&(val-1))
+                states[k]=LaneState::Open;
+            else
+                cells[cell]=__builtin_ctz(val)+1;
+        }
+    }
+}
+
+typedef void (*LockstepKernel)(const BoardView*, int, LaneState*);
+
+constexpr int maxLanes=16;
+
+void propagateGeneric(const BoardView* boards, int count,
+                      LaneState* states){
+    propagateBoards<Lanes8, 8>(boards, count, states);
+}
+
+#ifdef SUDOKU_LOCKSTEP_X86
+// flatten inlines the kernel, so it is compiled for AVX2 here
+__attribute__((target("avx2"), flatten))
+void propagateAvx2(const BoardView* boards, int count, LaneState* states){
+    propagateBoards<Lanes16, 16>(boards, count, states);
+}
+#endif
+
+struct LockstepDispatch{
+    LockstepDispatch(){
+        mKernel=propagateGeneric;
+        mWidth=8;
+        mIsa="generic";
+#ifdef SUDOKU_LOCKSTEP_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")){
+            mKernel=propagateAvx2;
+            mWidth=16;
+            mIsa="avx2";
+        }
+#endif
+    }
+    LockstepKernel mKernel;
+    int mWidth;
+    const char* mIsa;
+};
+
+const LockstepDispatch& dispatch(){
+    static const LockstepDispatch disp;
+    return disp;
+}
+
+SolveResult solveScalar(BoardView board){
+    return Table(board).trySolve();
+}
+
+} // namespace
+
+int lockstepWidth(){
+    return dispatch().mWidth;
+}
+
+const char* lockstepIsa(){
+    return dispatch().mIsa;
+}
+
+std::size_t trySolveLockstep(BoardView* boards, SolveResult* results,
+                             std::size_t count,
+                             const LockstepFallback& fallback) noexcept {
+    const LockstepDispatch& disp=dispatch();
+    std::size_t solvedNum=0;
+    auto finish=[&](BoardView board, SolveResult& res){
+        res=fallback ? fallback(board) : solveScalar(board);
+    };
+    BoardView batch[maxLanes];
+    std::size_t place[maxLanes];
+    LaneState states[maxLanes];
+    std::size_t next=0;
+    while (next<count){
+        int lanes=0;
+        for (; next<count && lanes<disp.mWidth; ++next){
+            if (boards[next].side()!=side || !boards[next].data()){
+                finish(boards[next], results[next]);
+                continue;
+            }
+            batch[lanes]=boards[next];
+            place[lanes++]=next;
+        }
+        if (lanes==0)
+            continue;
+        disp.mKernel(batch, lanes, states);
+        for (int k=0; k<lanes; ++k){
+            SolveResult& res=results[place[k]];
+            if (states[k]==LaneState::Solved){
+                res=SolveResult();
+                res.mStatus=SolveStatus::Solved;
+                ++solvedNum;
+            } else
+                finish(batch[k], res);
+        }
+    }
+    return solvedNum;
+}
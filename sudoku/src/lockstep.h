@@ -0,0 +1,43 @@
+/*
+ * lockstep.h
+ *
+ * Batch solver for 9x9 boards, one board per SIMD lane: candidates of
+ * a cell of all boards of a batch are one vector of 16 bit lanes.
+ * Naked and hidden singles run in lockstep for the whole batch,
+ * a board which needs a guess or has a contradiction drops out to
+ * the scalar solver with the cells found so far.
+ * Implementation is picked at run time: 16 boards at once with AVX2,
+ * 8 otherwise.
+ *
+ */
+
+#ifndef SUDOKU_LOCKSTEP_H
+#define SUDOKU_LOCKSTEP_H
+
+#include <cstddef>
+#include <functional>
+
+#include "sudoku.h"
+
+// boards propagated at once
+int lockstepWidth();
+// name of the implementation picked at run time: "avx2" or "generic"
+const char* lockstepIsa();
+
+// finishes a board propagation couldn't solve, must not throw
+using LockstepFallback=std::function<SolveResult(BoardView)>;
+
+/**
+ * @brief trySolveLockstep Solves count boards in place, results[i] is
+ * the result of boards[i], as Table::trySolve() would give. Boards
+ * which are not 9x9 or need more than singles go to fallback (by
+ * default Table::trySolve() with default settings), boards with
+ * a contradiction go there unchanged, so the status is exact.
+ * @return number of boards solved in lockstep, without fallback
+ */
+std::size_t trySolveLockstep(BoardView* boards, SolveResult* results,
+                             std::size_t count,
+                             const LockstepFallback& fallback=
+                                 LockstepFallback()) noexcept;
+
+#endif // SUDOKU_LOCKSTEP_H
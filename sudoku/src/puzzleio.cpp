@@ -0,0 +1,115 @@
+/* Puzzles input/output
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "puzzleio.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace {
+
+// symbols of values 62, 63 and 64
+const char highSymbols[]="@$%";
+
+int symbolValue(char ch, int side){
+    if (ch=='.' || ch=='0')
+        return 0;
+    if (ch>='1' && ch<='9')
+        return ch-'0';
+    if (ch>='A' && ch<='Z')
+        return ch-'A'+10;
+    if (ch>='a' && ch<='z')
+        return ch-'a'+(side>35 ? 36 : 10);
+    for (int k=0; highSymbols[k]; ++k)
+        if (ch==highSymbols[k])
+            return 62+k;
+    return -1;
+}
+
+char valueSymbol(int val){
+    if (val==0)
+        return '.';
+    if (val<10)
+        return char('0'+val);
+    if (val<36)
+        return char('A'+val-10);
+    return val<62 ? char('a'+val-36) : highSymbols[val-62];
+}
+
+}
+
+bool parsePuzzleLine(const char* beg, const char* end, Board& board){
+    if (end>beg && end[-1]=='\r')
+        --end;
+    int area=int(end-beg), box=1;
+    while (box*box*box*box<area)
+        ++box;
+    if (box*box*box*box!=area || box>Table::mMaxBox)
+        return false;
+    int side=box*box;
+    board.resize(side);
+    for (int i=0; i<side; ++i){
+        for (int j=0, val; j<side; ++j){
+            val=symbolValue(*beg++, side);
+            if (val<0 || val>side)
+                return false;
+            board[i][j]=std::uint8_t(val);
+        }
+    }
+    return true;
+}
+
+bool parsePuzzleLine(const char* beg, const char* end,
+                     std::vector<Row>& board){
+    Board flat(0);
+    if (!parsePuzzleLine(beg, end, flat))
+        return false;
+    flat.view().toRows(board);
+    return true;
+}
+
+void appendPuzzleLine(BoardView board, std::string& out){
+    const std::uint8_t* cell=board.data();
+    for (int i=0; i<board.cellsNum(); ++i)
+        out.push_back(valueSymbol(cell[i]));
+    out.push_back('\n');
+}
+
+void appendPuzzleLine(const std::vector<Row>& board, std::string& out){
+    for (auto& row: board)
+        for (auto val: row)
+            out.push_back(valueSymbol(val));
+    out.push_back('\n');
+}
+
+MappedFile::MappedFile(const std::string& fileName){
+    int fd=open(fileName.c_str(), O_RDONLY);
+    if (fd<0)
+        throw std::runtime_error("Unable to open "+fileName);
+    struct stat fileStat;
+    if (fstat(fd, &fileStat)<0){
+        close(fd);
+        throw std::runtime_error("Unable to stat "+fileName);
+    }
+    mSize=fileStat.st_size;
+    if (mSize){
+        void* addr=mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr==MAP_FAILED){
+            close(fd);
+            throw std::runtime_error("Unable to map "+fileName);
+        }
+        // file is read once from the beginning to the end
+        madvise(addr, mSize, MADV_SEQUENTIAL);
+        mData=static_cast<const char*>(addr);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile(){
+    if (mData)
+        munmap(const_cast<char*>(mData), mSize);
+}
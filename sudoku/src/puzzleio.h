@@ -0,0 +1,61 @@
+/*
+ * puzzleio.h
+ *
+ * Reading and writing of puzzles in one-line format and
+ * read-only memory mapping of puzzle files.
+ *
+ * One line holds one board row by row, side*side characters:
+ * '.' or '0' is an empty cell, '1'-'9' are values 1-9 and
+ * 'A'-'Z' are values 10-35, so 9x9 boards take 81 characters,
+ * 16x16 - 256 and 25x25 - 625. Boards up to 25x25 take 'a'-'z' for
+ * 'A'-'Z' as well, on larger ones (36x36 up to 64x64) 'a'-'z' are
+ * values 36-61 and '@', '$', '%' are 62, 63 and 64.
+ *
+ */
+
+#ifndef SUDOKU_PUZZLEIO_H
+#define SUDOKU_PUZZLEIO_H
+
+#include <cstddef>
+#include <string>
+
+#include "sudoku.h"
+
+/**
+ * @brief parsePuzzleLine Parses one line [beg, end) into board.
+ * Trailing '\r' is ignored.
+ * @return false if line length is not a supported board area
+ * or line contains improper symbols.
+ */
+bool parsePuzzleLine(const char* beg, const char* end,
+                     std::vector<Row>& board);
+
+// same for the flat board, doesn't allocate
+bool parsePuzzleLine(const char* beg, const char* end, Board& board);
+
+/**
+ * @brief appendPuzzleLine Appends board in one-line format and '\n'.
+ */
+void appendPuzzleLine(const std::vector<Row>& board, std::string& out);
+void appendPuzzleLine(BoardView board, std::string& out);
+
+/**
+ * @brief The MappedFile class Maps whole file read only for its
+ * lifetime. Throws std::runtime_error if file can't be mapped.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& fileName);
+    ~MappedFile();
+    MappedFile(const MappedFile& mf)=delete;
+    MappedFile& operator=(const MappedFile& mf)=delete;
+    const char* begin() const {return mData;}
+    const char* end() const {return mData+mSize;}
+    std::size_t size() const {return mSize;}
+private:
+    const char* mData=nullptr;
+    std::size_t mSize=0;
+};
+
+#endif // SUDOKU_PUZZLEIO_H
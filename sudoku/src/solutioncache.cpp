@@ -0,0 +1,100 @@
+/* Cache of solutions of canonical boards
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "solutioncache.h"
+
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace {
+
+std::string keyOf(BoardView board){
+    return std::string(reinterpret_cast<const char*>(board.data()),
+                       board.cellsNum());
+}
+
+} // namespace
+
+SolutionCache::SolutionCache(std::size_t capacity, int shardsNum)
+    : mCapacity(capacity), mHits(0), mMisses(0)
+{
+    if (shardsNum<1)
+        shardsNum=1;
+    mShardCapacity=(capacity+shardsNum-1)/shardsNum;
+    for (int i=0; i<shardsNum; ++i)
+        mShards.emplace_back(new Shard);
+}
+
+SolutionCache::Shard& SolutionCache::shardOf(const std::string& key){
+    return *mShards[std::hash<std::string>()(key)%mShards.size()];
+}
+
+bool SolutionCache::find(BoardView canonical, Board& solution) noexcept {
+    try {
+        std::string key=keyOf(canonical);
+        Shard& shard=shardOf(key);
+        std::lock_guard<std::mutex> lck(shard.mMutex);
+        auto it=shard.mSolutions.find(key);
+        if (it==shard.mSolutions.end()){
+            ++mMisses;
+            return false;
+        }
+        shard.mOrder.splice(shard.mOrder.begin(), shard.mOrder,
+                            it->second.mPlace);
+        solution.resize(canonical.side());
+        std::memcpy(solution.view().data(), it->second.mSolution.data(),
+                    it->second.mSolution.size());
+        ++mHits;
+        return true;
+    } catch (std::bad_alloc&) {
+        ++mMisses;
+        return false;
+    }
+}
+
+void SolutionCache::insert(BoardView canonical,
+                           BoardView solution) noexcept {
+    if (mShardCapacity==0)
+        return;
+    try {
+        std::string key=keyOf(canonical);
+        Shard& shard=shardOf(key);
+        std::lock_guard<std::mutex> lck(shard.mMutex);
+        auto res=shard.mSolutions.emplace(std::move(key), Shard::Entry());
+        if (!res.second)
+            return; // another thread has solved it too
+        try {
+            res.first->second.mSolution=keyOf(solution);
+            shard.mOrder.push_front(&res.first->first);
+        } catch (std::bad_alloc&) {
+            shard.mSolutions.erase(res.first);
+            return;
+        }
+        res.first->second.mPlace=shard.mOrder.begin();
+        if (shard.mSolutions.size()>mShardCapacity){
+            shard.mSolutions.erase(*shard.mOrder.back());
+            shard.mOrder.pop_back();
+        }
+    } catch (std::bad_alloc&) {
+    }
+}
+
+void SolutionCache::clear() noexcept {
+    for (auto& shard: mShards){
+        std::lock_guard<std::mutex> lck(shard->mMutex);
+        shard->mSolutions.clear();
+        shard->mOrder.clear();
+    }
+    mHits=0;
+    mMisses=0;
+}
+
+std::size_t SolutionCache::size() const noexcept {
+    std::size_t res=0;
+    for (auto& shard: mShards){
+        std::lock_guard<std::mutex> lck(shard->mMutex);
+        res+=shard->mSolutions.size();
+    }
+    return res;
+}
@@ -0,0 +1,67 @@
+/*
+ * solutioncache.h
+ *
+ * Solutions of canonical boards (see canonical.h), shared by threads.
+ * Equivalent puzzles have the same canonical form, so a solution found
+ * for one of them is mapped to all the others by their transforms.
+ *
+ */
+
+#ifndef SUDOKU_SOLUTIONCACHE_H
+#define SUDOKU_SOLUTIONCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "board.h"
+
+/**
+ * @brief The SolutionCache class Keeps up to capacity solutions,
+ * the least recently used one is dropped first. Boards are spread over
+ * shards by the hash of the board, every shard has its own lock, so
+ * threads rarely wait for each other. Methods don't throw: a solution
+ * which can't be kept because of memory is just not kept.
+ */
+class SolutionCache
+{
+public:
+    explicit
+    SolutionCache(std::size_t capacity=1<<16, int shardsNum=16);
+    SolutionCache(const SolutionCache& sc)=delete;
+    SolutionCache& operator=(const SolutionCache& sc)=delete;
+
+    // solution gets the solution of the canonical board if it is kept
+    bool find(BoardView canonical, Board& solution) noexcept;
+    void insert(BoardView canonical, BoardView solution) noexcept;
+    void clear() noexcept;
+    std::size_t size() const noexcept;
+    std::size_t getCapacity() const {return mCapacity;}
+    long long getHitsNum() const {return mHits;}
+    long long getMissesNum() const {return mMisses;}
+private:
+    struct Shard{
+        // solutions by boards, mOrder has keys of mSolutions,
+        // the most recently used first
+        using Order=std::list<const std::string*>;
+        struct Entry{
+            std::string mSolution;
+            Order::iterator mPlace;
+        };
+        mutable std::mutex mMutex;
+        std::unordered_map<std::string, Entry> mSolutions;
+        Order mOrder;
+    };
+    std::size_t mCapacity, mShardCapacity;
+    std::vector<std::unique_ptr<Shard>> mShards;
+    std::atomic<long long> mHits, mMisses;
+
+    Shard& shardOf(const std::string& key);
+};
+
+#endif // SUDOKU_SOLUTIONCACHE_H
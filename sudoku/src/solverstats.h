@@ -0,0 +1,73 @@
+/*
+ * solverstats.h
+ *
+ * Search statistics of the propagation engine. Counters are
+ * collected only when the solver is built with SUDOKU_STATS defined
+ * (make STATS=1), otherwise every update is an `if (false)` and
+ * compiles to nothing, all values stay zero.
+ *
+ */
+
+#ifndef SUDOKU_SOLVERSTATS_H
+#define SUDOKU_SOLVERSTATS_H
+
+#include <chrono>
+
+struct SolverStats
+{
+#ifdef SUDOKU_STATS
+    static constexpr bool mEnabled=true;
+#else
+    static constexpr bool mEnabled=false;
+#endif
+    using Clock=std::chrono::steady_clock;
+
+    // mNodes - positions where a cell had to be guessed,
+    // mGuesses - values tried there, mBacktracks - guesses undone,
+    // mNakedSingles/mHiddenSingles - cells assigned by propagation
+    long long mNodes=0, mGuesses=0, mBacktracks=0, mMaxDepth=0;
+    long long mNakedSingles=0, mHiddenSingles=0;
+    // seconds spent placing clues, in propagation (at any depth)
+    // and in the whole backtracking search (propagation included)
+    double mInitTime=0, mPropagateTime=0, mSearchTime=0;
+
+    void add(const SolverStats& other){
+        mNodes+=other.mNodes;
+        mGuesses+=other.mGuesses;
+        mBacktracks+=other.mBacktracks;
+        if (mMaxDepth<other.mMaxDepth)
+            mMaxDepth=other.mMaxDepth;
+        mNakedSingles+=other.mNakedSingles;
+        mHiddenSingles+=other.mHiddenSingles;
+        mInitTime+=other.mInitTime;
+        mPropagateTime+=other.mPropagateTime;
+        mSearchTime+=other.mSearchTime;
+    }
+};
+
+/**
+ * Adds time of its scope to the given counter, does nothing
+ * (doesn't even read the clock) if statistics are disabled.
+ */
+class StatsTimer
+{
+public:
+    explicit StatsTimer(double& counter): mCounter(counter){
+        if (SolverStats::mEnabled)
+            mStart=SolverStats::Clock::now();
+    }
+    ~StatsTimer(){
+        if (SolverStats::mEnabled){
+            std::chrono::duration<double> dur=
+                SolverStats::Clock::now()-mStart;
+            mCounter+=dur.count();
+        }
+    }
+    StatsTimer(const StatsTimer&)=delete;
+    StatsTimer& operator=(const StatsTimer&)=delete;
+private:
+    double& mCounter;
+    SolverStats::Clock::time_point mStart;
+};
+
+#endif // SUDOKU_SOLVERSTATS_H
@@ -1,309 +1,1121 @@
-/* Sudoku solver
-* author Mykola Fedorenko stnikolay@ukr.net
-* this solver uses backtracking algorithm 
-* with search for single elements and hidden single
-*/
-#include "sudoku.h"
-
-int BitMask::getBit(int index){
-    --index;
-    return ((mVal[index/32]&(1ull<<(index%32)))&&1);
-}
-
-int BitMask::getIndex(){
-    int index=0;
-    unsigned long long xNum;
-    unsigned long long binSearchConst[]=
-        {0x2, 0xC, 0xF0, 0xFF00, 0xFFFF0000};
-    int shifts[]={1,2,4,8,16};
-    for (auto& el:mVal){
-        if (el){
-            xNum=el;
-            for (int i=4; i>=0; --i){
-                if (xNum & binSearchConst[i]){
-                    xNum>>=shifts[i];
-                    index|=shifts[i];
-                }
-            }
-        }
-    }
-    ++index;
-    return index;
-}
-
-inline BitMask& BitMask::unSet(int index){
-    --index;
-    mVal[index/32]&=~(1ull<<(index%32));
-    return *this;
-} 
-
-int BitMask::getBitsNum(){
-    int counter=0, locCounter;
-    unsigned int num;
-    for (std::size_t i=0; i<mVal.size(); ++i){
-        num=mVal[i];
-        if (num==0) break;
-        for (locCounter=0; num; ++locCounter){
-            num&=num-1;
-        }
-        counter+=locCounter;
-    }
-    return counter;
-}
-
-BitMask operator | (const BitMask& x, const BitMask& y){
-    BitMask res(x);
-    for (std::size_t i=0; i<x.mVal.size(); ++i)
-        res.mVal[i]|=y.mVal[i];
-    return res;
-}
-BitMask operator & (const BitMask& x, const BitMask& y){
-    BitMask res(x);
-    for (std::size_t i=0; i<x.mVal.size(); ++i)
-        res.mVal[i]&=y.mVal[i];
-    return res;
-}
-BitMask operator ^ (const BitMask& x, const BitMask& y){
-    BitMask res(x);
-    for (std::size_t i=0; i<x.mVal.size(); ++i)
-        res.mVal[i]^=y.mVal[i];
-    return res;
-}
-
-void Table::initTable(std::vector<BitMask>& hlMasks, 
-                      std::vector<BitMask>& vlMasks, 
-                      std::vector<BitMask>& boxMasks){
-    //scan lines for initial numbers
-    if (mBox*mBox!=mSize) 
-        throw BadInitTableSizeException();
-    for (int i=0, tmp=0; i<mSize; ++i){
-        for (int j=0; j<mSize; ++j){
-            tmp=mTable[i][j];
-            if (tmp){
-                if (!hlMasks[i].getBit(tmp)||!vlMasks[j].getBit(tmp)||
-                    !boxMasks[i-i%mBox+j/mBox].getBit(tmp))
-                    throw ImproperAssignmentException(i, j);
-                hlMasks[i].unSet(tmp);
-                vlMasks[j].unSet(tmp);
-                boxMasks[i-i%mBox+j/mBox].unSet(tmp);
-                ++mSolvedCells;
-            }
-        }
-    }
-}
-
-inline 
-void Table::updateCell(std::vector<Row>& table, int x, int y, int num, 
-                       std::vector<BitMask>& hlMasks,
-                       std::vector<BitMask>& vlMasks, 
-                       std::vector<BitMask>& boxMasks){
-    table[x][y]=num;
-    hlMasks[x].unSet(num);
-    vlMasks[y].unSet(num);
-    boxMasks[x-x%mBox+y/mBox].unSet(num);
-    ++mSolvedCells;
-}
-
-bool Table::searchTable(std::vector<Row>& curTable, 
-                       std::vector<BitMask>& hlMasks, 
-                       std::vector<BitMask>& vlMasks, 
-                       std::vector<BitMask>& boxMasks){
-    static std::vector<std::vector<BitMask>> 
-        tbl(mSize, std::vector<BitMask>(mSize, BitMask(mSize)));
-    //set possible numbers for cells and search for single
-    BitMask curMask(mSize);
-    int possibleValues=0, minAll=mSize;
-    for (int i=0; i<mSize; ++i){
-        for (int j=0; j<mSize; ++j){
-            if (curTable[i][j]==0){
-                curMask=hlMasks[i] & vlMasks[j] 
-                    & boxMasks[i-i%mBox+j/mBox];
-                possibleValues=curMask.getBitsNum();
-                if (possibleValues>1){
-                    if (minAll>possibleValues){
-                        minAll=possibleValues;
-                        mLowestCount.iRow=i;
-                        mLowestCount.jCol=j;
-                    }
-                }else if (possibleValues==1){
-                    updateCell(curTable, i, j, curMask.getIndex(), 
-                               hlMasks, vlMasks, boxMasks);
-                    continue;
-                } else if (possibleValues==0){
-                    if (isBacktrackingEnabled)
-                        return false;
-                    else
-                        throw ImproperAssignmentException(i, j);
-                }
-                tbl[i][j]=curMask;
-            }
-        }
-    }
-    //search for hidden elems
-    searchHidden(curTable, tbl, hlMasks, vlMasks, boxMasks);
-    return true;
-}
-inline 
-bool Table::searchHidden(std::vector<Row>& curTable, 
-                        std::vector<std::vector<BitMask>>& tbl, 
-                        std::vector<BitMask>& hlMasks, 
-                        std::vector<BitMask>& vlMasks, 
-                        std::vector<BitMask>& boxMasks){    
-    // search for hidden single elems
-    //in rows
-    BitMask curMask(mSize), sumMask(mSize), andMask(mSize);
-    BitMask emptyMask(mSize), tmpMask(mSize);
-    emptyMask.clear();
-    for (int i=0; i<mSize; ++i){
-        sumMask=hlMasks[i];
-        curMask=emptyMask;
-        for (int j=0; j<mSize; ++j){
-            if (curTable[i][j]==0){
-                andMask=curMask & tbl[i][j];
-                curMask=(curMask ^ tbl[i][j]) & sumMask;
-                sumMask=sumMask ^ andMask;
-            }
-        }
-        if (curMask.getBitsNum()){
-            for (int k=0; k<mSize; ++k){
-                if (curTable[i][k]==0){
-                    tmpMask=curMask & tbl[i][k];
-                    if (tmpMask!=emptyMask){
-                        updateCell(curTable, i, k, tmpMask.getIndex(), 
-                                   hlMasks, vlMasks, boxMasks);
-                    }
-                }
-            }
-        }
-    }
-    //in cols
-    for (int j=0; j<mSize; ++j){
-        sumMask=vlMasks[j];
-        curMask=emptyMask;
-        for (int i=0; i<mSize; ++i){
-            if (curTable[i][j]==0){
-                andMask=curMask & tbl[i][j];
-                curMask=(curMask ^ tbl[i][j]) & sumMask;
-                sumMask=sumMask ^ andMask;
-            }
-        }
-        if (curMask.getBitsNum()){
-            for (int k=0; k<mSize; ++k){
-                if (curTable[k][j]==0){
-                    tmpMask=curMask & tbl[k][j];
-                    if (tmpMask!=emptyMask){
-                        updateCell(curTable, k, j, tmpMask.getIndex(),
-                                   hlMasks, vlMasks, boxMasks);
-                    }
-                }
-            }
-        }
-    }
-    //in boxes
-    for (int boxInd=0, iBeg, iEnd, jBeg, jEnd; 
-                    boxInd<mSize; ++boxInd){
-        iBeg=(boxInd/mBox)*mBox;
-        iEnd=iBeg+mBox;
-        jBeg=(boxInd%mBox)*mBox;
-        jEnd=jBeg+mBox;
-        sumMask=boxMasks[boxInd];
-        curMask=emptyMask;
-        for (int i=iBeg; i<iEnd ; ++i){
-            for (int j=jBeg; j<jEnd; ++j){
-                if (curTable[i][j]==0){
-                    andMask=curMask & tbl[i][j];
-                    curMask=(curMask ^ tbl[i][j]) & sumMask;
-                    sumMask=sumMask ^ andMask;
-                }
-            }
-        }
-        if (curMask.getBitsNum()){
-            for(int i=iBeg; i<iEnd; ++i){
-                for (int j=jBeg; j<jEnd; ++j){
-                    if (curTable[i][j]==0){
-                        tmpMask=curMask & tbl[i][j];
-                        if (tmpMask!=emptyMask){
-                            updateCell(curTable, i, j, tmpMask.getIndex(),
-                                       hlMasks, vlMasks, boxMasks);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return true;
-}
-
-bool Table::sudokuBacktrack(std::vector<Row> curTable, 
-                            std::vector<BitMask> hlMasks, 
-                            std::vector<BitMask> vlMasks, 
-                            std::vector<BitMask> boxMasks){
-    int prevSolvedNum=-1;
-    while (prevSolvedNum!=mSolvedCells){
-        prevSolvedNum=mSolvedCells;
-        if (!searchTable(curTable, hlMasks, vlMasks, boxMasks)){
-            return false;
-        }
-    }
-    if (mSolvedCells==mSize*mSize){
-        mTable=curTable;
-        return true;
-    }
-    int tRow=mLowestCount.iRow, tCol=mLowestCount.jCol;
-    int boxInd=tRow-tRow%mBox+tCol/mBox;
-    BitMask optElemMask=hlMasks[tRow] & vlMasks[tCol] & boxMasks[boxInd];
-    int bitsNum=optElemMask.getBitsNum();
-    BitMask prevHlM, prevVlM, prevBox;
-    for (int k=0, ind, prevSolved; k<bitsNum; ++k){
-        //attempt to guess value
-        ind=optElemMask.getIndex();
-        optElemMask.unSet(ind);
-        prevSolved=mSolvedCells;
-        prevHlM=hlMasks[tRow];
-        prevVlM=vlMasks[tCol];
-        prevBox=boxMasks[boxInd];
-        updateCell(curTable, tRow, tCol, ind,
-                  hlMasks, vlMasks, boxMasks);
-        if (sudokuBacktrack(curTable, hlMasks, vlMasks, boxMasks)){
-            return true;
-        }
-        //bad guess return to prev values
-        mSolvedCells=prevSolved;
-        hlMasks[tRow]=prevHlM;
-        vlMasks[tCol]=prevVlM;
-        boxMasks[boxInd]=prevBox;
-    }
-    return false;
-}
-
-std::vector<Row> Table::sudoku() {
-    std::vector<BitMask> hLineMasks(mSize, BitMask(mSize));
-    std::vector<BitMask> vLineMasks(mSize, BitMask(mSize));
-    std::vector<BitMask> boxMasks(mSize, BitMask(mSize));
-    try{
-    initTable(hLineMasks, vLineMasks, boxMasks);
-    }
-    catch(ImproperAssignmentException& rAs){
-        std::cout<<"Error! : "<<rAs.what()<<std::endl;
-        return mTable;
-    }
-    catch (BadInitTableSizeException& bInTab){
-        std::cout<<"Error! : "<<bInTab.what()<<std::endl;
-        return mTable;
-    }
-    //finds elements in table without any assumptions 
-    int prevSolvedNum=-1;
-    while (prevSolvedNum!=mSolvedCells){
-        prevSolvedNum=mSolvedCells;
-        searchTable(mTable, hLineMasks, vLineMasks, boxMasks);
-    }
-    if (mSolvedCells==mSize*mSize)
-        return mTable;
-    //backtrack rest of the elements if there are unsolved
-    isBacktrackingEnabled=true;
-    if(!sudokuBacktrack(mTable, hLineMasks, vLineMasks, boxMasks)){
-        std::cout<<"Unable to solve this sudoku!"<<std::endl;
-    }
-    return mTable;
-}
-
+/* Sudoku solver
+* author Mykola Fedorenko stnikolay@ukr.net
+* this solver uses backtracking algorithm
+* with search for single elements and hidden single
+*/
+#include "sudoku.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#include "canonical.h"
+#include "dlx.h"
+#include "hiddensimd.h"
+#include "solutioncache.h"
+#include "workstealing.h"
+
+namespace {
+/**
+ * Buffers of finished solves kept by every thread, so a thread
+ * solving many boards reuses their capacity instead of allocating.
+ * Only the owning thread touches its free list, no locks needed.
+ */
+class ScratchArena
+{
+public:
+    static std::vector<int> take(std::size_t capacity){
+        std::vector<int> buf;
+        if (!tFree.empty()){
+            buf.swap(tFree.back());
+            tFree.pop_back();
+        }
+        buf.reserve(capacity);
+        return buf;
+    }
+    static void give(std::vector<int>& buf){
+        if (buf.capacity()==0 || tFree.size()>=mMaxBuffers)
+            return;
+        buf.clear();
+        try {
+            tFree.push_back(std::move(buf));
+        } catch (std::bad_alloc&) {
+            // the buffer is freed instead, destructors give them back
+        }
+    }
+private:
+    static constexpr std::size_t mMaxBuffers=16;
+    static thread_local std::vector<std::vector<int>> tFree;
+};
+
+thread_local std::vector<std::vector<int>> ScratchArena::tFree;
+}
+
+/**
+ * State shared by all tasks of one parallel search. The first
+ * solution found is kept, reaching the limit of solutions
+ * stops all other tasks.
+ */
+template <int Order>
+struct BasicTable<Order>::SharedSearch
+{
+    SharedSearch(int thrNum, long long limit)
+        : mPool(thrNum), mStop(false), mIsAborted(false), mNodesNum(0),
+          mLimit(limit){}
+    WorkStealingPool mPool;
+    std::atomic_bool mStop, mIsAborted;
+    // nodes of all tasks, for the node limit
+    std::atomic<long long> mNodesNum;
+    long long mLimit, mSolutionsNum=0;
+    std::mutex mMutex;
+    bool mIsFound=false;
+    std::array<std::uint8_t, mCells> mSolution;
+    // eliminations and statistics of all finished tasks
+    Deductions mDeductions;
+    SolverStats mStats;
+};
+
+template <int Order>
+BasicTable<Order>::Geometry::Geometry(){
+    for (int i=0; i<mSize; ++i){
+        for (int j=0; j<mSize; ++j){
+            int cell=i*mSize+j, box=i-i%mBox+j/mBox;
+            mUnitCells[i][j]=cell;
+            mUnitCells[mSize+j][i]=cell;
+            mUnitCells[2*mSize+box][(i%mBox)*mBox+j%mBox]=cell;
+            mCellUnits[cell]={{i, mSize+j, 2*mSize+box}};
+            mCellLanes[cell]={{j*mSize+i, mCells+cell,
+                2*mCells+((i%mBox)*mBox+j%mBox)*mSize+box}};
+        }
+    }
+    mBandPlaces.fill(Mask::empty());
+    mStackPlaces.fill(Mask::empty());
+    for (int k=0; k<mSize; ++k){
+        mBandPlaces[k/mBox].set(k+1);
+        mStackPlaces[k%mBox].set(k+1);
+    }
+    for (int cell=0; cell<mCells; ++cell){
+        // in the order of cells, only rows of the band have
+        // more peers than the one in the column
+        int i=cell/mSize, j=cell%mSize, k=0;
+        for (int pi=0; pi<mSize; ++pi){
+            if (pi/mBox!=i/mBox){
+                mCellPeers[cell][k++]=pi*mSize+j;
+                continue;
+            }
+            for (int pj=0; pj<mSize; ++pj){
+                if ((pi!=i || pj!=j) && (pi==i || pj==j ||
+                    pj/mBox==j/mBox))
+                    mCellPeers[cell][k++]=pi*mSize+pj;
+            }
+        }
+    }
+}
+
+template <int Order>
+const typename BasicTable<Order>::Geometry& BasicTable<Order>::geometry(){
+    static const Geometry geo;
+    return geo;
+}
+
+template <int Order>
+BasicTable<Order>::~BasicTable(){
+    ScratchArena::give(mTrail);
+    ScratchArena::give(mQueue);
+}
+
+template <int Order>
+bool BasicTable<Order>::initTable(){
+    static_assert(sizeof(Mask)==sizeof(typename Mask::Word),
+                  "hidden singles kernel needs one word masks");
+    mLanes.fill(Mask());
+    mPlaced.fill(Mask::empty());
+    mDirty.fill(Mask()); // every unit is checked at least once
+    // a table may be solved again: the counters and the buffers of
+    // the previous solve are dropped, its cells are clues now
+    mSolvedCells=0;
+    mSolutionsNum=0;
+    mDepth=0;
+    mConflictCell=-1;
+    ScratchArena::give(mTrail);
+    ScratchArena::give(mQueue);
+    mTrail=ScratchArena::take(mCells*(mSize+1));
+    mQueue=ScratchArena::take(mCells);
+    //place initial numbers, propagation is done after all of them
+    for (int cell=0, tmp=0; cell<mCells; ++cell){
+        tmp=mBoard[cell];
+        if (tmp){
+            mBoard[cell]=0;
+            if (tmp>mSize||!assignCell(cell, tmp)){
+                // board keeps all clues, as before the call
+                mBoard[cell]=tmp;
+                mConflictCell=cell;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::assignCell(int cell, int num){
+    std::uint8_t& val=mBoard[cell];
+    if (val)
+        return val==num;
+    if (!candidates(cell).getBit(num)){
+        mConflictCell=cell;
+        return false;
+    }
+    val=num;
+    mTrail.push_back(-(cell+1));
+    ++mSolvedCells;
+    for (int unit: geometry().mCellUnits[cell])
+        mPlaced[unit].set(num);
+    Mask others=candidates(cell);
+    others.unSet(num);
+    for (int ind; others.any();){
+        ind=others.getLowIndex();
+        others.unSet(ind);
+        if (!eliminate(cell, ind))
+            return false;
+    }
+    // only peers of the cell are affected
+    for (int peer: geometry().mCellPeers[cell]){
+        if (candidates(peer).getBit(num) && !eliminate(peer, num))
+            return false;
+    }
+    return true;
+}
+
+template <int Order>
+inline
+bool BasicTable<Order>::eliminate(int cell, int num){
+    Mask& cand=candidates(cell);
+    if (!cand.getBit(num))
+        return true;
+    const Geometry& geo=geometry();
+    for (int kind=0; kind<3; ++kind){
+        mLanes[geo.mCellLanes[cell][kind]].unSet(num);
+        mDirty[kind].set(geo.mCellUnits[cell][kind]-kind*mSize+1);
+    }
+    mTrail.push_back(cell*mSize+num-1);
+    int left=cand.getBitsNum();
+    if (left==1 && mBoard[cell]==0)
+        mQueue.push_back(cell);
+    else if (left==0){
+        mConflictCell=cell;
+        return false;
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::findHiddenSingles(){
+    using Word=typename Mask::Word;
+    const Geometry& geo=geometry();
+    std::array<Mask, mSize+mLanesPad> once, seen;
+    for (int kind=0; kind<3; ++kind){
+        if (!mDirty[kind].any())
+            continue;
+        hiddenSinglesKernel(
+            reinterpret_cast<const Word*>(&mLanes[kind*mCells]), mSize,
+            mSize, reinterpret_cast<Word*>(once.data()),
+            reinterpret_cast<Word*>(seen.data()));
+        Mask dirty=mDirty[kind];
+        mDirty[kind].clear(); // assignments below mark units again
+        while (dirty.any()){
+            int ind=dirty.getLowIndex(), unit=kind*mSize+ind-1;
+            dirty.unSet(ind);
+            const auto& unitCells=geo.mUnitCells[unit];
+            if (seen[ind-1]!=Mask()){
+                mConflictCell=unitCells[0]; // some value has no place
+                return false;
+            }
+            Mask hidden=once[ind-1]&~mPlaced[unit];
+            for (int num; hidden.any();){
+                num=hidden.getLowIndex();
+                hidden.unSet(num);
+                // the only place of num, it can be gone after
+                // previous assignments, then unit has a conflict
+                int cell=0;
+                while (cell<mSize && !candidates(unitCells[cell]).getBit(num))
+                    ++cell;
+                if (cell==mSize){
+                    mConflictCell=unitCells[0];
+                    return false;
+                }
+                if (SolverStats::mEnabled && !isAssigned(unitCells[cell]))
+                    ++mStats.mHiddenSingles;
+                if (!assignCell(unitCells[cell], num))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+void BasicTable<Order>::unitPlaces(int unit, Places& places){
+    // bit k+1 of places[num-1] is set if k-th cell of the unit
+    // can hold num, values assigned in the unit have no places
+    for (auto& valPlaces: places)
+        valPlaces.clear();
+    const auto& unitCells=geometry().mUnitCells[unit];
+    for (int k=0; k<mSize; ++k){
+        int cell=unitCells[k];
+        if (mBoard[cell])
+            continue;
+        for (Mask rest=candidates(cell); rest.any();){
+            int val=rest.getLowIndex();
+            rest.unSet(val);
+            places[val-1].set(k+1);
+        }
+    }
+}
+
+template <int Order>
+inline bool BasicTable<Order>::removeCandidate(int cell, int num,
+                                               Deductions::Rule rule){
+    if (!candidates(cell).getBit(num))
+        return true;
+    mDeductions.addElimination(rule);
+    return eliminate(cell, num);
+}
+
+template <int Order>
+bool BasicTable<Order>::nakedSubsets(int size, Deductions::Rule rule){
+    // size cells of a unit with only size values between them,
+    // these values can't be anywhere else in the unit
+    std::array<int, mSize> pos;
+    std::array<Mask, mSize> cand;
+    for (int unit=0; unit<mUnits; ++unit){
+        const auto& unitCells=geometry().mUnitCells[unit];
+        int num=0;
+        for (int k=0; k<mSize; ++k){
+            int cell=unitCells[k], left=candidates(cell).getBitsNum();
+            if (mBoard[cell]==0 && left>1 && left<=size){
+                pos[num]=k;
+                cand[num++]=candidates(cell);
+            }
+        }
+        for (int a=0; a<num; ++a){
+            for (int b=a+1; b<num; ++b){
+                // pairs make a single pass of this loop
+                for (int c=(size==2 ? num-1 : b+1); c<num; ++c){
+                    Mask values=cand[a]|cand[b];
+                    if (size==3)
+                        values|=cand[c];
+                    if (values.getBitsNum()!=size)
+                        continue;
+                    for (int k=0; k<mSize; ++k){
+                        if (k==pos[a] || k==pos[b] ||
+                            (size==3 && k==pos[c]))
+                            continue;
+                        for (Mask rest=values&candidates(unitCells[k]);
+                             rest.any();){
+                            int val=rest.getLowIndex();
+                            rest.unSet(val);
+                            if (!removeCandidate(unitCells[k], val, rule))
+                                return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::hiddenSubsets(int size, Deductions::Rule rule){
+    // size values of a unit with only size places between them,
+    // these places can't hold any other value
+    std::array<int, mSize> vals;
+    Places places;
+    for (int unit=0; unit<mUnits; ++unit){
+        const auto& unitCells=geometry().mUnitCells[unit];
+        unitPlaces(unit, places);
+        int num=0;
+        for (int val=1; val<=mSize; ++val){
+            int left=places[val-1].getBitsNum();
+            if (left>1 && left<=size){
+                vals[num]=val;
+                places[num++]=places[val-1];
+            }
+        }
+        for (int a=0; a<num; ++a){
+            for (int b=a+1; b<num; ++b){
+                // pairs make a single pass of this loop
+                for (int c=(size==2 ? num-1 : b+1); c<num; ++c){
+                    Mask cells=places[a]|places[b];
+                    Mask keep=Mask::single(vals[a]).set(vals[b]);
+                    if (size==3){
+                        cells|=places[c];
+                        keep.set(vals[c]);
+                    }
+                    if (cells.getBitsNum()!=size)
+                        continue;
+                    for (int k; cells.any();){
+                        k=cells.getLowIndex();
+                        cells.unSet(k);
+                        int cell=unitCells[k-1];
+                        for (Mask rest=candidates(cell)&~keep; rest.any();){
+                            int val=rest.getLowIndex();
+                            rest.unSet(val);
+                            if (!removeCandidate(cell, val, rule))
+                                return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::pointing(){
+    // places of a value in a box are all in one row (column),
+    // so the value leaves the rest of this row (column)
+    const Geometry& geo=geometry();
+    Places places;
+    for (int unit=2*mSize; unit<mUnits; ++unit){
+        unitPlaces(unit, places);
+        int corner=geo.mUnitCells[unit][0];
+        for (int val=1; val<=mSize; ++val){
+            Mask valPlaces=places[val-1];
+            if (!valPlaces.any())
+                continue;
+            for (int s=0; s<mBox; ++s){
+                int line=-1;
+                if ((valPlaces&~geo.mBandPlaces[s])==Mask::empty())
+                    line=corner/mSize+s;
+                else if ((valPlaces&~geo.mStackPlaces[s])==Mask::empty())
+                    line=mSize+corner%mSize+s;
+                if (line<0)
+                    continue;
+                for (int cell: geo.mUnitCells[line]){
+                    if (geo.mCellUnits[cell][2]!=unit &&
+                        !removeCandidate(cell, val, Deductions::Pointing))
+                        return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::claiming(){
+    // places of a value in a row (column) are all in one box,
+    // so the value leaves the rest of this box
+    const Geometry& geo=geometry();
+    Places places;
+    for (int unit=0; unit<2*mSize; ++unit){
+        unitPlaces(unit, places);
+        int kind=unit<mSize ? 0 : 1;
+        for (int val=1; val<=mSize; ++val){
+            Mask valPlaces=places[val-1];
+            if (!valPlaces.any())
+                continue;
+            for (int s=0; s<mBox; ++s){
+                if ((valPlaces&~geo.mBandPlaces[s])!=Mask::empty())
+                    continue;
+                int box=geo.mCellUnits[geo.mUnitCells[unit][s*mBox]][2];
+                for (int cell: geo.mUnitCells[box]){
+                    if (geo.mCellUnits[cell][kind]!=unit &&
+                        !removeCandidate(cell, val, Deductions::Claiming))
+                        return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::xWing(){
+    // two rows with the same two places of a value, the value leaves
+    // other rows of these columns (and the same for columns)
+    const Geometry& geo=geometry();
+    std::array<Places, mSize> linePlaces;
+    std::array<int, mSize> lines;
+    for (int base=0; base<2*mSize; base+=mSize){
+        for (int i=0; i<mSize; ++i)
+            unitPlaces(base+i, linePlaces[i]);
+        // crossing lines are of the other kind
+        int cross=mSize-base;
+        for (int val=1; val<=mSize; ++val){
+            int num=0;
+            for (int i=0; i<mSize; ++i)
+                if (linePlaces[i][val-1].getBitsNum()==2)
+                    lines[num++]=i;
+            for (int a=0; a<num; ++a){
+                for (int b=a+1; b<num; ++b){
+                    const Mask& valPlaces=linePlaces[lines[a]][val-1];
+                    if (valPlaces!=linePlaces[lines[b]][val-1])
+                        continue;
+                    for (Mask rest=valPlaces; rest.any();){
+                        int k=rest.getLowIndex();
+                        rest.unSet(k);
+                        const auto& crossCells=geo.mUnitCells[cross+k-1];
+                        for (int i=0; i<mSize; ++i){
+                            if (i!=lines[a] && i!=lines[b] &&
+                                !removeCandidate(crossCells[i], val,
+                                                 Deductions::XWing))
+                                return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::applyDeductions(){
+    // stops after the first rule which changed anything,
+    // so that cheap singles are tried again first
+    std::size_t trailSize=mTrail.size();
+    for (int ind=0; ind<Deductions::RulesNum; ++ind){
+        auto rule=Deductions::Rule(ind);
+        if (!mDeductions.isEnabled(rule))
+            continue;
+        bool isOk=true;
+        switch (rule){
+        case Deductions::NakedPairs: isOk=nakedSubsets(2, rule); break;
+        case Deductions::NakedTriples: isOk=nakedSubsets(3, rule); break;
+        case Deductions::HiddenPairs: isOk=hiddenSubsets(2, rule); break;
+        case Deductions::HiddenTriples: isOk=hiddenSubsets(3, rule); break;
+        case Deductions::Pointing: isOk=pointing(); break;
+        case Deductions::Claiming: isOk=claiming(); break;
+        default: isOk=xWing(); break;
+        }
+        if (!isOk)
+            return false;
+        if (mTrail.size()!=trailSize)
+            break;
+    }
+    return true;
+}
+
+template <int Order>
+bool BasicTable<Order>::propagate(){
+    // naked singles first (queue grows while they are assigned),
+    // then hidden singles of changed units, then enabled deductions,
+    // until nothing changes
+    StatsTimer timer(mStats.mPropagateTime);
+    while (true){
+        for (std::size_t head=0; head<mQueue.size(); ++head){
+            int cell=mQueue[head];
+            if (SolverStats::mEnabled && !isAssigned(cell))
+                ++mStats.mNakedSingles;
+            if (!assignCell(cell, candidates(cell).getIndex())){
+                mQueue.clear();
+                return false;
+            }
+        }
+        mQueue.clear();
+        bool isOk=true;
+        if (mDirty[0].any() || mDirty[1].any() || mDirty[2].any()){
+            isOk=findHiddenSingles();
+        } else {
+            if (!mDeductions.any())
+                return true;
+            std::size_t trailSize=mTrail.size();
+            isOk=applyDeductions();
+            if (isOk && mTrail.size()==trailSize)
+                return true;
+        }
+        if (!isOk){
+            mQueue.clear();
+            return false;
+        }
+    }
+}
+
+template <int Order>
+std::uint64_t BasicTable<Order>::random(){
+    std::uint64_t z=(mRandom+=0x9E3779B97F4A7C15ULL);
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z=(z^(z>>27))*0x94D049BB133111EBULL;
+    return z^(z>>31);
+}
+
+template <int Order>
+template <class Rules>
+int BasicTable<Order>::selectBranchCell(){
+    // unsolved cell with minimum remaining values,
+    // ties are broken by the rule
+    int minAll=mSize+1, best=-1, bestDegree=-1, ties=0;
+    for (int cell=0, possibleValues; cell<mCells; ++cell){
+        if (mBoard[cell])
+            continue;
+        possibleValues=candidates(cell).getBitsNum();
+        if (possibleValues>minAll)
+            continue;
+        bool isLess=possibleValues<minAll;
+        if (Rules::mCell==CellRule::FirstMrv){
+            if (isLess){
+                minAll=possibleValues;
+                best=cell;
+                if (minAll==2)
+                    break;
+            }
+        } else if (Rules::mCell==CellRule::MrvDegree){
+            int degree=0;
+            for (int peer: geometry().mCellPeers[cell])
+                degree+=mBoard[peer]==0;
+            if (isLess || degree>bestDegree){
+                minAll=possibleValues;
+                best=cell;
+                bestDegree=degree;
+            }
+        } else {
+            // every tie is taken with equal probability
+            ties=isLess ? 1 : ties+1;
+            if (isLess || random()%ties==0){
+                minAll=possibleValues;
+                best=cell;
+            }
+        }
+    }
+    return best;
+}
+
+template <int Order>
+template <class Rules>
+int BasicTable<Order>::orderValues(int cell, Values& values){
+    int valuesNum=0;
+    Mask rest=candidates(cell);
+    for (; rest.any(); ++valuesNum){
+        values[valuesNum]=rest.getIndex();
+        rest.unSet(values[valuesNum]);
+    }
+    if (Rules::mValue==ValueRule::LeastConstraining){
+        // candidates of unsolved peers each value would remove,
+        // higher values first among equal ones
+        std::array<int, mSize+1> removed;
+        removed.fill(0);
+        for (int peer: geometry().mCellPeers[cell]){
+            if (mBoard[peer])
+                continue;
+            for (int k=0; k<valuesNum; ++k)
+                removed[values[k]]+=candidates(peer).getBit(values[k]);
+        }
+        std::sort(values.begin(), values.begin()+valuesNum,
+                  [&removed](int a, int b){
+            return removed[a]<removed[b] || (removed[a]==removed[b] && a>b);
+        });
+    } else if (Rules::mValue==ValueRule::Random){
+        for (int k=valuesNum-1; k>0; --k)
+            std::swap(values[k], values[random()%(k+1)]);
+    }
+    return valuesNum;
+}
+
+template <int Order>
+void BasicTable<Order>::undoTo(std::size_t trailSize){
+    mQueue.clear();
+    for (int entry, cell, num; mTrail.size()>trailSize; mTrail.pop_back()){
+        entry=mTrail.back();
+        if (entry<0){
+            cell=-entry-1;
+            std::uint8_t& val=mBoard[cell];
+            for (int unit: geometry().mCellUnits[cell])
+                mPlaced[unit].unSet(val);
+            val=0;
+            --mSolvedCells;
+        } else {
+            cell=entry/mSize;
+            num=entry%mSize+1;
+            for (int lane: geometry().mCellLanes[cell])
+                mLanes[lane].set(num);
+        }
+    }
+    // state before the guess was fully propagated
+    for (auto& dirty: mDirty)
+        dirty.clear();
+}
+
+template <int Order>
+bool BasicTable<Order>::recordSolution(){
+    if (!mShared)
+        return ++mSolutionsNum>=mLimit;
+    std::lock_guard<std::mutex> lck(mShared->mMutex);
+    if (mShared->mStop)
+        return true;
+    if (!mShared->mIsFound){
+        mShared->mSolution=mBoard;
+        mShared->mIsFound=true;
+    }
+    if (++mShared->mSolutionsNum>=mShared->mLimit)
+        mShared->mStop=true;
+    return mShared->mStop;
+}
+
+template <int Order>
+template <class Rules>
+bool BasicTable<Order>::sudokuBacktrack(){
+    if (mShared && mShared->mStop.load(std::memory_order_relaxed))
+        return true; // somebody else has already finished the search
+    if (!propagate()){
+        return false;
+    }
+    if (mSolvedCells==mCells){
+        return recordSolution();
+    }
+    int cell=selectBranchCell<Rules>();
+    if ((mNodeLimit || mTimeLimit.count()) && !takeNode())
+        return true;
+    if (mRestartLimit && ++mRestartNodes>mRestartLimit){
+        mIsRestarted=true;
+        return true;
+    }
+    if (SolverStats::mEnabled){
+        ++mStats.mNodes;
+        if (mStats.mMaxDepth<mDepth+1)
+            mStats.mMaxDepth=mDepth+1;
+    }
+    Values values;
+    int valuesNum=orderValues<Rules>(cell, values);
+    if (mShared && mDepth<mSplitDepth){
+        // keep the first value for this thread, the rest can be stolen;
+        // a branch which can't be given away is tried here together
+        // with the values before it
+        int k=valuesNum-1;
+        while (k>0 && spawnBranch<Rules>(cell, values[k]))
+            --k;
+        valuesNum=k+1;
+    }
+    std::size_t prevTrail=mTrail.size();
+    for (int k=0; k<valuesNum; ++k){
+        //attempt to guess value
+        if (SolverStats::mEnabled)
+            ++mStats.mGuesses;
+        if (assignCell(cell, values[k])){
+            ++mDepth;
+            bool isFinished=sudokuBacktrack<Rules>();
+            --mDepth;
+            if (isFinished){
+                return true;
+            }
+        }
+        //bad guess (or all its solutions are counted), undo it
+        //and everything propagated from it
+        if (SolverStats::mEnabled)
+            ++mStats.mBacktracks;
+        undoTo(prevTrail);
+    }
+    return false;
+}
+
+template <int Order>
+bool BasicTable<Order>::takeNode(){
+    long long nodesNum=mShared ? ++mShared->mNodesNum : ++mNodesNum;
+    if ((!mNodeLimit || nodesNum<=mNodeLimit) &&
+            (!mTimeLimit.count() || nodesNum%mClockNodes ||
+             std::chrono::steady_clock::now()<mDeadline))
+        return true;
+    mIsAborted=true;
+    if (mShared){
+        mShared->mIsAborted=true;
+        mShared->mStop=true;
+    }
+    return false;
+}
+
+template <int Order>
+template <class Rules>
+bool BasicTable<Order>::spawnBranch(int cell, int num){
+    try {
+        // task gets a copy of the current state, its own trail starts
+        // empty
+        BasicTable branch(*this);
+        branch.mTrail.clear();
+        branch.mDeductions.clearEliminations();
+        branch.mStats=SolverStats();
+        branch.mRandom^=random(); // branches don't repeat each other
+        mShared->mPool.submit([branch, cell, num]() mutable {
+            if (SolverStats::mEnabled)
+                ++branch.mStats.mGuesses;
+            if (branch.assignCell(cell, num)){
+                ++branch.mDepth;
+                branch.template sudokuBacktrack<Rules>();
+            }
+            branch.addSharedCounters();
+        });
+    } catch (std::bad_alloc&) {
+        return false;
+    }
+    return true;
+}
+
+template <int Order>
+void BasicTable<Order>::addSharedCounters(){
+    std::lock_guard<std::mutex> lck(mShared->mMutex);
+    mShared->mDeductions.addEliminations(mDeductions);
+    mShared->mStats.add(mStats);
+}
+
+template <int Order>
+template <class Rules>
+long long BasicTable<Order>::searchParallel(int thrNum){
+    SharedSearch shared(thrNum, mLimit);
+    BasicTable root(*this);
+    root.mTrail.clear();
+    root.mDeductions.clearEliminations();
+    root.mStats=SolverStats();
+    root.mShared=&shared;
+    shared.mPool.submit([&root]{
+        root.template sudokuBacktrack<Rules>();
+        root.addSharedCounters();
+    });
+    shared.mPool.wait();
+    mIsAborted=shared.mIsAborted;
+    mDeductions.addEliminations(shared.mDeductions);
+    mStats.add(shared.mStats);
+    if (!shared.mIsFound)
+        return 0;
+    // solution is kept in the trail too, so it can be undone as usual
+    for (int cell=0; cell<mCells; ++cell)
+        if (mBoard[cell]==0)
+            assignCell(cell, shared.mSolution[cell]);
+    return shared.mSolutionsNum;
+}
+
+template <int Order>
+bool BasicTable<Order>::propagateClues() {
+    mDeductions.clearEliminations();
+    mStats=SolverStats();
+    {
+        StatsTimer timer(mStats.mInitTime);
+        if (!initTable())
+            return false;
+    }
+    //finds elements in table without any assumptions
+    return propagate();
+}
+
+template <int Order>
+void BasicTable<Order>::throwConflict() const {
+    throw ImproperAssignmentException(mConflictCell/mSize,
+                                      mConflictCell%mSize);
+}
+
+template <int Order>
+template <class Rules>
+void BasicTable<Order>::searchWith(int thrNum){
+    if (thrNum!=1){
+        mSolutionsNum=searchParallel<Rules>(thrNum);
+        return;
+    }
+    // restarts would count solutions again, so only for the first one
+    if (mBranching!=Branching::RandomRestarts || mLimit!=1){
+        sudokuBacktrack<Rules>();
+        return;
+    }
+    std::size_t prevTrail=mTrail.size();
+    for (mRestartLimit=mFirstRestart; ; mRestartLimit*=2){
+        mRestartNodes=0;
+        mIsRestarted=false;
+        sudokuBacktrack<Rules>();
+        if (!mIsRestarted)
+            break;
+        undoTo(prevTrail);
+    }
+    mRestartLimit=0;
+}
+
+template <int Order>
+long long BasicTable<Order>::search(long long limit, int thrNum) {
+    mLimit=limit;
+    mNodesNum=0;
+    mIsAborted=false;
+    if (mTimeLimit.count())
+        mDeadline=std::chrono::steady_clock::now()+mTimeLimit;
+    if (mSolvedCells==mCells)
+        return 1;
+    //backtrack rest of the elements if there are unsolved
+    std::size_t prevTrail=mTrail.size();
+    {
+        StatsTimer timer(mStats.mSearchTime);
+        switch (mBranching){
+        case Branching::MrvDegree:
+            searchWith<Policy<CellRule::MrvDegree, ValueRule::Highest>>(
+                        thrNum);
+            break;
+        case Branching::LeastConstraining:
+            searchWith<Policy<CellRule::FirstMrv,
+                              ValueRule::LeastConstraining>>(thrNum);
+            break;
+        case Branching::RandomRestarts:
+            searchWith<Policy<CellRule::RandomMrv, ValueRule::Random>>(
+                        thrNum);
+            break;
+        default:
+            searchWith<Policy<CellRule::FirstMrv, ValueRule::Highest>>(
+                        thrNum);
+        }
+    }
+    if (mSolvedCells!=mCells)
+        undoTo(prevTrail);
+    return mSolutionsNum;
+}
+
+template <int Order>
+SolveResult BasicTable<Order>::trySolve(int thrNum) noexcept {
+    SolveResult result;
+    try {
+        if (!propagateClues()){
+            result.mStatus=SolveStatus::ImproperClue;
+            result.mRow=mConflictCell/mSize;
+            result.mCol=mConflictCell%mSize;
+            return result;
+        }
+        long long solutionsNum;
+        try {
+            solutionsNum=search(1, thrNum);
+        } catch (std::exception&) {
+            if (thrNum==1)
+                throw;
+            // no threads or memory for the workers, the board isn't
+            // changed until they finish, so this thread searches alone
+            solutionsNum=search(1, 1);
+        }
+        if (solutionsNum>0)
+            result.mStatus=SolveStatus::Solved;
+        else if (mIsAborted)
+            result.mStatus=SolveStatus::Aborted;
+    } catch (std::exception&) {
+        // no memory for the buffers of the search
+        mIsAborted=true;
+        result.mStatus=SolveStatus::Aborted;
+    }
+    return result;
+}
+
+template <int Order>
+bool BasicTable<Order>::solve(int thrNum) {
+    SolveResult result=trySolve(thrNum);
+    if (result.mStatus==SolveStatus::ImproperClue)
+        throw ImproperAssignmentException(result.mRow, result.mCol);
+    return result.isSolved();
+}
+
+template <int Order>
+long long BasicTable<Order>::countSolutions(long long limit, int thrNum) {
+    if (!propagateClues())
+        throwConflict();
+    return search(limit, thrNum);
+}
+
+template <int Order>
+bool BasicTable<Order>::solveWithoutGuessing() {
+    if (!propagateClues())
+        throwConflict();
+    return mSolvedCells==mCells;
+}
+
+template <int Order>
+std::vector<Row> BasicTable<Order>::sudoku() {
+    trySolve();
+    return getTable();
+}
+
+template <int Order>
+BasicTable<Order>::BasicTable(BoardView board){
+    std::copy(board.data(), board.data()+mCells, mBoard.begin());
+}
+
+template <int Order>
+BasicTable<Order>::BasicTable(const std::vector<Row>& inMatr){
+    mBoard.fill(0);
+    if (!BoardView(mBoard.data(), mSize).fromRows(inMatr))
+        throw BadInitTableSizeException();
+}
+
+template <int Order>
+std::vector<Row> BasicTable<Order>::getTable() const {
+    std::vector<Row> rows;
+    BoardView(const_cast<std::uint8_t*>(mBoard.data()), mSize).toRows(rows);
+    return rows;
+}
+
+template <int Order>
+void BasicTable<Order>::copyTo(BoardView board) const {
+    std::copy(mBoard.begin(), mBoard.end(), board.data());
+}
+
+template class BasicTable<1>;
+template class BasicTable<2>;
+template class BasicTable<3>;
+template class BasicTable<4>;
+template class BasicTable<5>;
+template class BasicTable<6>;
+template class BasicTable<7>;
+template class BasicTable<8>;
+
+Table::Table(const std::vector<Row>& inMatr):
+    mSize{int(inMatr.size())},
+    mBox{int(std::sqrt(mSize))}
+{
+    // improper sizes are reported by solve()
+    if (mSize<=Board::mMaxSide){
+        mOwned.assign(mSize*mSize, 0);
+        if (board().fromRows(inMatr))
+            return;
+    }
+    mOwned.clear();
+    mSize=mBox=0;
+}
+
+template <int Order>
+SolveResult Table::solveOrder() noexcept {
+    BasicTable<Order> table(board());
+    table.setDeductions(mDeductions);
+    table.setNodeLimit(mNodeLimit);
+    table.setTimeLimit(mTimeLimit);
+    table.setBranching(mBranching);
+    SolveResult result=table.trySolve(mThreadsNum);
+    if (result.mStatus!=SolveStatus::ImproperClue)
+        table.copyTo(board());
+    mDeductions=table.getDeductions();
+    mStats=table.getStats();
+    mIsAborted=table.isAborted();
+    return result;
+}
+
+template <int Order>
+long long Table::countOrder(long long limit) {
+    BasicTable<Order> table(board());
+    table.setDeductions(mDeductions);
+    table.setNodeLimit(mNodeLimit);
+    table.setTimeLimit(mTimeLimit);
+    table.setBranching(mBranching);
+    long long solutionsNum=table.countSolutions(limit, mThreadsNum);
+    mDeductions=table.getDeductions();
+    mStats=table.getStats();
+    mIsAborted=table.isAborted();
+    return solutionsNum;
+}
+
+template <int Order>
+bool Table::deduceOrder() {
+    BasicTable<Order> table(board());
+    table.setDeductions(mDeductions);
+    bool isSolved=table.solveWithoutGuessing();
+    table.copyTo(board());
+    mDeductions=table.getDeductions();
+    mStats=table.getStats();
+    mIsAborted=table.isAborted();
+    return isSolved;
+}
+
+void Table::checkSize() const {
+    if (!isProperSize())
+        throw BadInitTableSizeException();
+}
+
+SolveResult Table::trySolve() noexcept {
+    mIsAborted=false;
+    mIsCacheHit=false;
+    if (!isProperSize()){
+        SolveResult result;
+        result.mStatus=SolveStatus::ImproperSize;
+        return result;
+    }
+    return mCache ? solveCached() : solveBoard();
+}
+
+SolveResult Table::solveCached() noexcept {
+    Board canonical, solution;
+    BoardTransform transform;
+    // boards which can't be canonized are solved as usual
+    bool isCanonical=canonicalize(board(), canonical, transform);
+    SolveResult result;
+    if (isCanonical && mCache->find(canonical.view(), solution)){
+        transform.applyInverse(solution.view(), board());
+        mIsCacheHit=true;
+        mStats=SolverStats();
+        mDeductions.clearEliminations();
+        result.mStatus=SolveStatus::Solved;
+        return result;
+    }
+    result=solveBoard();
+    if (isCanonical && result.isSolved()){
+        solution.resize(mSize);
+        transform.apply(board(), solution.view());
+        mCache->insert(canonical.view(), solution.view());
+    }
+    return result;
+}
+
+SolveResult Table::solveBoard() noexcept {
+    if (mEngine==Engine::DancingLinks)
+        return trySolveDancingLinks(board());
+    switch (mBox){
+    case 1: return solveOrder<1>();
+    case 2: return solveOrder<2>();
+    case 3: return solveOrder<3>();
+    case 4: return solveOrder<4>();
+    case 5: return solveOrder<5>();
+    case 6: return solveOrder<6>();
+    case 7: return solveOrder<7>();
+    default: return solveOrder<8>();
+    }
+}
+
+bool Table::solve() {
+    SolveResult result=trySolve();
+    if (result.mStatus==SolveStatus::ImproperSize)
+        throw BadInitTableSizeException();
+    if (result.mStatus==SolveStatus::ImproperClue)
+        throw ImproperAssignmentException(result.mRow, result.mCol);
+    return result.isSolved();
+}
+
+bool Table::solve(std::vector<Row>& result) {
+    bool isSolved=solve();
+    board().toRows(result);
+    return isSolved;
+}
+
+long long Table::countSolutions(long long limit) {
+    checkSize();
+    switch (mBox){
+    case 1: return countOrder<1>(limit);
+    case 2: return countOrder<2>(limit);
+    case 3: return countOrder<3>(limit);
+    case 4: return countOrder<4>(limit);
+    case 5: return countOrder<5>(limit);
+    case 6: return countOrder<6>(limit);
+    case 7: return countOrder<7>(limit);
+    default: return countOrder<8>(limit);
+    }
+}
+
+bool Table::solveWithoutGuessing() {
+    checkSize();
+    switch (mBox){
+    case 1: return deduceOrder<1>();
+    case 2: return deduceOrder<2>();
+    case 3: return deduceOrder<3>();
+    case 4: return deduceOrder<4>();
+    case 5: return deduceOrder<5>();
+    case 6: return deduceOrder<6>();
+    case 7: return deduceOrder<7>();
+    default: return deduceOrder<8>();
+    }
+}
+
+std::vector<Row> Table::sudoku() {
+    trySolve();
+    std::vector<Row> result;
+    board().toRows(result);
+    return result;
+}
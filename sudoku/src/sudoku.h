@@ -9,53 +9,348 @@
 #ifndef SUDOKU_H
 #define SUDOKU_H
 
-#include <iostream>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <exception>
+#include <array>
 
-typedef int Cell;
-typedef std::vector<Cell> Row;
-class BitMask;
+#include "bitmask.h"
+#include "board.h"
+#include "hiddensimd.h"
+#include "solverstats.h"
+
+class SolutionCache;
+
+/**
+ * Deductions which propagation applies when singles are exhausted,
+ * before any guess. Every rule is enabled separately and counts
+ * candidates it has eliminated during the last search.
+ */
+class Deductions
+{
+public:
+    // Pointing - value of a box is confined to one line of the box,
+    // Claiming - value of a line is confined to one box
+    enum Rule {NakedPairs, NakedTriples, HiddenPairs, HiddenTriples,
+               Pointing, Claiming, XWing, RulesNum};
+    static Deductions all(){
+        Deductions res;
+        res.mEnabled=(1u<<RulesNum)-1;
+        return res;
+    }
+    Deductions& enable(Rule rule, bool isOn=true){
+        if (isOn)
+            mEnabled|=1u<<rule;
+        else
+            mEnabled&=~(1u<<rule);
+        return *this;
+    }
+    bool isEnabled(Rule rule) const {return (mEnabled>>rule)&1;}
+    bool any() const {return mEnabled!=0;}
+    long long getEliminations(Rule rule) const {return mEliminations[rule];}
+    void addElimination(Rule rule){++mEliminations[rule];}
+    void addEliminations(const Deductions& other){
+        for (int i=0; i<RulesNum; ++i)
+            mEliminations[i]+=other.mEliminations[i];
+    }
+    void clearEliminations(){mEliminations.fill(0);}
+private:
+    unsigned mEnabled=0;
+    std::array<long long, RulesNum> mEliminations{{}};
+};
+
+/**
+ * Outcome of the noexcept solve entry points, the board itself is
+ * solved in place. ImproperSize - board side is not a supported
+ * square, ImproperClue - mRow, mCol is a clue out of range or
+ * contradicting the others, Aborted - the node or time limit is reached
+ * or there is no memory for the search.
+ */
+enum class SolveStatus {Solved, NoSolution, ImproperSize, ImproperClue,
+                        Aborted};
+
+struct SolveResult
+{
+    SolveStatus mStatus=SolveStatus::NoSolution;
+    int mRow=-1, mCol=-1;
+    bool isSolved() const {return mStatus==SolveStatus::Solved;}
+};
+
+/**
+ * Branching of the Propagation search: which cell gets a guess and in
+ * which order its values are tried.
+ * Mrv - the first cell with the fewest candidates, values from the
+ * highest one;
+ * MrvDegree - of the cells with the fewest candidates the one with most
+ * unsolved peers, values from the highest one;
+ * LeastConstraining - Mrv cell, values which are candidates of fewer
+ * unsolved peers first;
+ * RandomRestarts - random cell of the ones with the fewest candidates,
+ * values in random order, a search for one solution on one thread
+ * starts again after a number of nodes, which doubles every time.
+ */
+enum class Branching {Mrv, MrvDegree, LeastConstraining, RandomRestarts};
+
+/**
+ * Solver for a board of a fixed order (box side), so that board side
+ * is Order*Order. All candidate masks have compile-time width.
+ */
+template <int Order>
+class BasicTable
+{
+public:
+    static constexpr int mBox=Order, mSize=Order*Order, mCells=mSize*mSize;
+    // rows, columns and boxes
+    static constexpr int mUnits=3*mSize;
+    static constexpr int mPeers=2*(mSize-1)+(mBox-1)*(mBox-1);
+    using Mask=BitMask<mSize>;
+
+    // board side must be mSize, cells are copied
+    explicit BasicTable(BoardView board);
+    explicit BasicTable(const std::vector<Row>& inMatr);
+    BasicTable(const BasicTable&)=default;
+    // scratch buffers go back to the arena of the current thread
+    ~BasicTable();
+    // solves and returns the board reached, errors are not reported
+    std::vector<Row> sudoku();
+    // solves without exceptions, bad clues are a status too.
+    // With thrNum!=1 branches of the first mSplitDepth search levels
+    // are stolen by idle workers of a WorkStealingPool (0 - all cores),
+    // if its threads can't be started the search is serial
+    SolveResult trySolve(int thrNum=1) noexcept;
+    // same, returns false if there is no solution,
+    // throws ImproperAssignmentException on bad clues
+    bool solve(int thrNum=1);
+    // number of solutions, search stops as soon as limit is reached
+    // (limit 2 is enough to check that solution is unique)
+    long long countSolutions(long long limit, int thrNum=1);
+    // search gives up after nodes positions with a guess (0 - no
+    // limit), isAborted() tells if the last search did so
+    void setNodeLimit(long long nodes){mNodeLimit=nodes;}
+    // same for the wall time of a search (0 - no limit), the clock is
+    // read every mClockNodes nodes
+    void setTimeLimit(std::chrono::microseconds time){mTimeLimit=time;}
+    bool isAborted() const {return mIsAborted;}
+    // propagation only (singles and enabled Deductions), no guesses;
+    // true if it fills the whole board, throws like solve()
+    bool solveWithoutGuessing();
+    std::vector<Row> getTable() const;
+    // board reached by the search (the solution if it is found)
+    void copyTo(BoardView board) const;
+    void setDeductions(const Deductions& deductions){
+        mDeductions=deductions;
+    }
+    const Deductions& getDeductions() const {return mDeductions;}
+    // statistics of the last search, zeros unless built with SUDOKU_STATS
+    const SolverStats& getStats() const {return mStats;}
+    void setBranching(Branching branching){mBranching=branching;}
+private:
+    // Branching rules are compile-time policies of the search, so the
+    // inner loop has no calls through pointers, search() picks
+    // the instantiation once per search.
+    enum class CellRule {FirstMrv, MrvDegree, RandomMrv};
+    enum class ValueRule {Highest, LeastConstraining, Random};
+    template <CellRule Cell, ValueRule Value>
+    struct Policy{
+        static constexpr CellRule mCell=Cell;
+        static constexpr ValueRule mValue=Value;
+    };
+    // cells of every unit, units and peers of every cell,
+    // cell index is i*mSize+j
+    struct Geometry{
+        Geometry();
+        std::array<std::array<int, mSize>, mUnits> mUnitCells;
+        std::array<std::array<int, 3>, mCells> mCellUnits;
+        std::array<std::array<int, mPeers>, mCells> mCellPeers;
+        // index in mLanes of the cell for rows, columns and boxes
+        std::array<std::array<int, 3>, mCells> mCellLanes;
+        // positions of unit cells: band s is s*mBox..s*mBox+mBox-1
+        // (a box of a line or a row of a box), stack s is s, s+mBox, ...
+        // (a column of a box), bit k+1 for k-th cell
+        std::array<Mask, mBox> mBandPlaces, mStackPlaces;
+    };
+    static const Geometry& geometry();
+
+    // mBoard is the only board, search changes it in place.
+    // mLanes keeps possible values of every cell three times, once per
+    // kind of units: candidates of k-th cell of unit u of the kind are
+    // mLanes[kind*mCells+k*mSize+u], so hidden singles of all units of
+    // a kind are found by one pass of the SIMD kernel (hiddensimd.h).
+    // Column layout is the plain cell order, see candidates().
+    // mPlaced has values assigned in every unit and mDirty[kind] -
+    // units (bit u+1) changed since the last hidden singles pass.
+    // mTrail keeps every change since the start of the search, so any
+    // guess can be undone exactly: cell*mSize+num-1 for num removed
+    // from candidates and -(cell+1) for assigned cell.
+    // mQueue keeps cells which became naked singles.
+    // All state belongs to this object, so solvers on different
+    // threads share nothing; mTrail and mQueue storage is taken from
+    // a per-thread arena (see ScratchArena in sudoku.cpp).
+    static constexpr int mLanesPad=
+        (hiddenKernelPad+sizeof(Mask)-1)/sizeof(Mask);
+    alignas(64) std::array<std::uint8_t, mCells> mBoard;
+    std::array<Mask, 3*mCells+mLanesPad> mLanes;
+    std::array<Mask, mUnits> mPlaced;
+    std::array<Mask, 3> mDirty;
+    std::vector<int> mTrail, mQueue;
+    int mSolvedCells=0, mDepth=0, mConflictCell=-1;
+    long long mLimit=1, mSolutionsNum=0;
+    long long mNodeLimit=0, mNodesNum=0;
+    static constexpr long long mClockNodes=16;
+    std::chrono::microseconds mTimeLimit{0};
+    std::chrono::steady_clock::time_point mDeadline;
+    // restarts: nodes allowed to the current attempt (0 - no restarts)
+    static constexpr long long mFirstRestart=64;
+    long long mRestartLimit=0, mRestartNodes=0;
+    bool mIsAborted=false, mIsRestarted=false;
+    Branching mBranching=Branching::Mrv;
+    std::uint64_t mRandom=0x9E3779B97F4A7C15ULL;
+    static constexpr int mSplitDepth=8;
+    struct SharedSearch;
+    SharedSearch* mShared=nullptr;
+    Deductions mDeductions;
+    SolverStats mStats;
+    Mask& candidates(int cell){return mLanes[mCells+cell];}
+    bool isAssigned(int cell) const {return mBoard[cell]!=0;}
+    // false if a clue is improper, mConflictCell is the clue
+    bool initTable();
+    bool assignCell(int cell, int num);
+    bool eliminate(int cell, int num);
+    bool findHiddenSingles();
+    // deductions, false on a conflict
+    using Places=std::array<Mask, mSize>;
+    void unitPlaces(int unit, Places& places);
+    bool removeCandidate(int cell, int num, Deductions::Rule rule);
+    bool nakedSubsets(int size, Deductions::Rule rule);
+    bool hiddenSubsets(int size, Deductions::Rule rule);
+    bool pointing();
+    bool claiming();
+    bool xWing();
+    bool applyDeductions();
+    bool propagate();
+    // splitmix64, every table has its own sequence
+    std::uint64_t random();
+    template <class Rules>
+    int selectBranchCell();
+    // values of the cell in the order they are tried, returns their
+    // number (one spare item, GCC can't see that 1x1 boards never branch)
+    using Values=std::array<int, mSize+1>;
+    template <class Rules>
+    int orderValues(int cell, Values& values);
+    void undoTo(std::size_t trailSize);
+    // initTable() and propagate(), false on a contradiction
+    bool propagateClues();
+    void throwConflict() const;
+    template <class Rules>
+    bool sudokuBacktrack();
+    // counts a new search node, false if mNodeLimit or mDeadline
+    // is exceeded
+    bool takeNode();
+    bool recordSolution();
+    // false if there is no memory for the task
+    template <class Rules>
+    bool spawnBranch(int cell, int num);
+    void addSharedCounters();
+    template <class Rules>
+    long long searchParallel(int thrNum);
+    template <class Rules>
+    void searchWith(int thrNum);
+    long long search(long long limit, int thrNum);
+};
+
+/**
+ * Board of any supported size. Dispatches to BasicTable of the
+ * matching order (boxes 1x1 up to 8x8, i.e. boards up to 64x64).
+ * Works on a BoardView in place or on its own copy of a board of rows.
+ */
 class Table
 {
 public:
+    // Propagation - singles, hidden singles and enabled Deductions
+    // with backtracking,
+    // DancingLinks - exact cover search (see dlx.h)
+    enum class Engine {Propagation, DancingLinks};
+    static constexpr int mMaxBox=maxBoardBox;
 	Table() = default;
-	Table(std::vector<Row>& inMatr): 
-        mTable{inMatr},
-        mSolvedCells{0},
-        mSize{int(inMatr.size())},
+    // board is solved in place, it must outlive the Table
+    explicit Table(BoardView board):
+        mCells{board.data()},
+        mSize{board.side()},
         mBox{int(std::sqrt(mSize))}{}
+    // adapter for boards of rows, the board is copied
+    Table(const std::vector<Row>& inMatr);
+    // board reached by the solver, errors are not reported,
+    // improper size gives an empty board
     std::vector<Row> sudoku();
+    // doesn't throw and doesn't print, the board gets the board
+    // reached by the solver (unchanged on ImproperClue)
+    SolveResult trySolve() noexcept;
+    // same as BasicTable::solve(), also throws
+    // BadInitTableSizeException for unsupported sizes
+    bool solve();
+    // adapter, result gets the board reached by the solver
+    bool solve(std::vector<Row>& result);
+    BoardView board(){
+        return BoardView(mCells ? mCells : mOwned.data(), mSize);
+    }
+    // number of solutions up to limit, always uses Propagation engine
+    long long countSolutions(long long limit=2);
+    // see BasicTable::solveWithoutGuessing(), the board gets
+    // the cells found
+    bool solveWithoutGuessing();
+    // see BasicTable::setNodeLimit() and setTimeLimit(),
+    // Propagation engine only
+    void setNodeLimit(long long nodes){mNodeLimit=nodes;}
+    void setTimeLimit(std::chrono::microseconds time){mTimeLimit=time;}
+    bool isAborted() const {return mIsAborted;}
+    // threads for the search of one board, 1 - serial, 0 - all cores
+    void setThreadsNum(int thrNum){mThreadsNum=thrNum;}
+    void setEngine(Engine engine){mEngine=engine;}
+    // see Branching, Propagation engine only
+    void setBranching(Branching branching){mBranching=branching;}
+    // rules used by Propagation engine, eliminations of the last search
+    void setDeductions(const Deductions& deductions){
+        mDeductions=deductions;
+    }
+    const Deductions& getDeductions() const {return mDeductions;}
+    // see BasicTable::getStats()
+    const SolverStats& getStats() const {return mStats;}
+    // trySolve(), solve() and sudoku() look for the solution of an
+    // equivalent board in cache and put solutions there, nullptr - no
+    // cache. A hit doesn't search, stats and eliminations are zero.
+    // For a board with many solutions a hit gives one of them.
+    void setCache(SolutionCache* cache){mCache=cache;}
+    bool isCacheHit() const {return mIsCacheHit;}
 private:
-    std::vector<Row> mTable;
-    int mSolvedCells=0, mSize=0, mBox=0;
-    bool isBacktrackingEnabled=false;
-    struct LowestCountElement{
-    public:
-        int iRow=0, jCol=0;
-    } mLowestCount;
-    void initTable(std::vector<BitMask>& hlMask, 
-                   std::vector<BitMask>& vlMask, 
-                   std::vector<BitMask>& box);
-    bool searchTable(std::vector<Row>& tbl, 
-                    std::vector<BitMask>& hlMasks, 
-                    std::vector<BitMask>& vlMasks, 
-                    std::vector<BitMask>& boxMasks);
-    bool searchHidden(std::vector<Row>& curTable, 
-                     std::vector<std::vector<BitMask>>& tbl, 
-                     std::vector<BitMask>& hlMasks, 
-                     std::vector<BitMask>& vlMasks, 
-                     std::vector<BitMask>& boxMasks);
-    void updateCell(std::vector<Row>& tbl, int x, int y, int num, 
-                    std::vector<BitMask>& hlMasks,
-                    std::vector<BitMask>& vlMasks, 
-                    std::vector<BitMask>& boxMasks);
-    bool sudokuBacktrack(std::vector<Row> curTable, 
-                         std::vector<BitMask> hlMasks, 
-                         std::vector<BitMask> vlMasks, 
-                         std::vector<BitMask> boxMasks);
+    // mCells points to the board of the view, nullptr if mOwned is
+    // used (the copy of a board of rows)
+    std::vector<std::uint8_t> mOwned;
+    std::uint8_t* mCells=nullptr;
+    int mSize=0, mBox=0, mThreadsNum=1;
+    long long mNodeLimit=0;
+    std::chrono::microseconds mTimeLimit{0};
+    bool mIsAborted=false, mIsCacheHit=false;
+    SolutionCache* mCache=nullptr;
+    Engine mEngine=Engine::Propagation;
+    Branching mBranching=Branching::Mrv;
+    Deductions mDeductions;
+    SolverStats mStats;
+    bool isProperSize() const {
+        return mBox*mBox==mSize && mBox>=1 && mBox<=mMaxBox;
+    }
+    void checkSize() const;
+    // trySolve() without cache for a board of proper size
+    SolveResult solveBoard() noexcept;
+    SolveResult solveCached() noexcept;
+    template <int Order>
+    SolveResult solveOrder() noexcept;
+    template <int Order>
+    long long countOrder(long long limit);
+    template <int Order>
+    bool deduceOrder();
 };
 
 class BadInitTableSizeException: public std::exception {
@@ -68,35 +363,19 @@ public:
 class ImproperAssignmentException: public std::exception {
 public:
     ImproperAssignmentException(int x, int y)
-        :mX{x}, mY{y}{}
+        :mX{x}, mY{y}{
+        std::snprintf(mMessage, sizeof(mMessage),
+                      "Impossible number for Cell (%d, %d);", x, y);
+    }
     virtual const char* what() const throw(){
-        std::string errMessage=std::string("Impossible number for Cell (")
-            +std::to_string(mX)+", "+ std::to_string(mY)+");";
-        return errMessage.c_str();
+        return mMessage;
     }
+    int getRow() const {return mX;}
+    int getCol() const {return mY;}
 private:
     int mX=0, mY=0;
-};
-
-class BitMask
-{
-    using int32uns = unsigned long;
-    friend BitMask operator | (const BitMask& x, const BitMask& y);
-    friend BitMask operator & (const BitMask& x, const BitMask& y);
-    friend BitMask operator ^ (const BitMask& x, const BitMask& y);
-public:
-    BitMask():mVal(1, ~0ul){}
-    explicit BitMask(int bitLen):mVal(bitLen/32+1, ~0ul){
-        mVal.back()&=(1ull<<(bitLen%32))-1;}
-    bool operator==(const BitMask& rhs){return (mVal==rhs.mVal);}
-    bool operator!=(const BitMask& rhs){return (mVal!=rhs.mVal);}
-    int getIndex(); // returns index of a highest bit set
-    BitMask& unSet(int ind); //unsets bit with index 'ind'
-    int getBit(int ind); // returns bit with index 'ind'
-    int getBitsNum(); //returns a number of nonzero bits
-    void clear(){for (auto& el:mVal) el=0;}; // clear all bits
-private:
-    std::vector<int32uns> mVal;
+    // what() must outlive the call, so the message is kept here
+    char mMessage[64];
 };
 
 
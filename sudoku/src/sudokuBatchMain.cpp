@@ -0,0 +1,380 @@
+/**
+ * @brief Batch sudoku solver. Streams a file with one puzzle per line
+ * (see puzzleio.h for the format) through a memory mapping, solves
+ * puzzles on all cores and writes solutions in the input order.
+ * Puzzles which can't be solved are written unchanged.
+ * Statistics with puzzles/second goes to stderr, optionally with
+ * a histogram of solve times and solver counters (make STATS=1).
+ * With --cache puzzles equivalent to solved ones aren't searched
+ * again (see solutioncache.h). With --lockstep 9x9 puzzles are
+ * propagated a batch per SIMD vector (see lockstep.h).
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "lockstep.h"
+#include "puzzleio.h"
+#include "solutioncache.h"
+#include "sudoku.h"
+#include "workstealing.h"
+
+/**
+ * @brief The BatchSolver class Workers take chunks of lines from the
+ * mapped file and put solved chunks into mReady, the calling thread
+ * writes them strictly by chunk index. Workers can't run more than
+ * mWindow chunks ahead of the writer so memory stays bounded
+ * for any input size.
+ */
+class BatchSolver
+{
+public:
+    BatchSolver(const MappedFile& inFile, std::ostream& out, int thrNum,
+                Table::Engine engine, const Deductions& deductions)
+        : mCursor(inFile.begin()), mEnd(inFile.end()),
+          mOut(out), mThrNum(thrNum), mWindow(4*thrNum), mEngine(engine),
+          mDeductions(deductions){mHistogram.fill(0);}
+    // bucket b counts puzzles solved in [2^(b-1), 2^b) microseconds
+    static const int mBuckets=32;
+    using Histogram=std::array<long long, mBuckets>;
+    void run();
+    void setTimed(bool isTimed){mIsTimed=isTimed;}
+    void setCache(SolutionCache* cache){mCache=cache;}
+    void setBranching(Branching branching){mBranching=branching;}
+    // 9x9 puzzles are solved lockstepWidth() at once (see lockstep.h)
+    void setLockstep(bool isLockstep){mIsLockstep=isLockstep;}
+    long long getPuzzlesNum() const {return mPuzzles;}
+    long long getFailedNum() const {return mFailed;}
+    // lines which are not proper puzzles (a part of failed ones)
+    long long getInvalidNum() const {return mInvalid;}
+    const Histogram& getHistogram() const {return mHistogram;}
+    const SolverStats& getStats() const {return mStats;}
+private:
+    static const int mChunkLines=512;
+    const char* mCursor;
+    const char* mEnd;
+    std::ostream& mOut;
+    int mThrNum, mWindow;
+    Table::Engine mEngine;
+    Deductions mDeductions;
+    bool mIsTimed=false, mIsLockstep=false;
+    SolutionCache* mCache=nullptr;
+    Branching mBranching=Branching::Mrv;
+    std::size_t mNextChunk=0, mNextToWrite=0;
+    int mWorking=0;
+    long long mPuzzles=0, mFailed=0, mInvalid=0;
+    Histogram mHistogram;
+    SolverStats mStats;
+    std::map<std::size_t, std::string> mReady;
+    std::mutex mMutex;
+    std::condition_variable mWriterCond, mWorkerCond;
+
+    bool takeChunk(const char*& beg, const char*& end, std::size_t& ind);
+    void solveChunk(const char* beg, const char* end, std::string& out);
+    void workerFunction();
+};
+
+bool BatchSolver::takeChunk(const char*& beg, const char*& end,
+                            std::size_t& ind){
+    std::unique_lock<std::mutex> lck(mMutex);
+    mWorkerCond.wait(lck, [this]{
+        return mCursor==mEnd || mNextChunk<mNextToWrite+mWindow;});
+    if (mCursor==mEnd)
+        return false;
+    beg=mCursor;
+    for (int i=0; i<mChunkLines && mCursor!=mEnd; ++i){
+        auto eol=static_cast<const char*>(
+                    std::memchr(mCursor, '\n', mEnd-mCursor));
+        mCursor=eol ? eol+1 : mEnd;
+    }
+    end=mCursor;
+    ind=mNextChunk++;
+    return true;
+}
+
+void BatchSolver::solveChunk(const char* beg, const char* end,
+                             std::string& out){
+    long long puzzles=0, failed=0, invalid=0;
+    Histogram histogram;
+    histogram.fill(0);
+    SolverStats stats;
+    auto record=[&](const char* line, const char* eol, BoardView board,
+                    const SolveResult& result, long long micros){
+        if (mIsTimed){
+            int bucket=0;
+            while (micros>0 && bucket<mBuckets-1){
+                micros>>=1;
+                ++bucket;
+            }
+            ++histogram[bucket];
+        }
+        if (result.isSolved()){
+            appendPuzzleLine(board, out);
+        } else {
+            ++failed;
+            invalid+=result.mStatus==SolveStatus::ImproperSize
+                    || result.mStatus==SolveStatus::ImproperClue;
+            out.append(line, eol);
+            out.push_back('\n');
+        }
+    };
+    auto solveTable=[&](BoardView board){
+        Table table(board);
+        table.setEngine(mEngine);
+        table.setDeductions(mDeductions);
+        table.setCache(mCache);
+        table.setBranching(mBranching);
+        SolveResult result=table.trySolve();
+        stats.add(table.getStats());
+        return result;
+    };
+    auto now=[this]{
+        return mIsTimed ? std::chrono::steady_clock::now()
+                        : std::chrono::steady_clock::time_point();
+    };
+    auto microsSince=[](std::chrono::steady_clock::time_point sTime){
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now()-sTime).count();
+    };
+    // lockstep mode keeps lines of a group until the group is solved
+    const int groupSize=mIsLockstep ? lockstepWidth() : 1;
+    std::vector<Board> boards(groupSize);
+    std::vector<const char*> lines, eols;
+    std::vector<BoardView> views;
+    std::vector<SolveResult> results(groupSize);
+    auto solveGroup=[&]{
+        auto sTime=now();
+        trySolveLockstep(views.data(), results.data(), views.size(),
+                         solveTable);
+        long long micros=mIsTimed ? microsSince(sTime)/views.size() : 0;
+        for (std::size_t i=0; i<views.size(); ++i)
+            record(lines[i], eols[i], views[i], results[i], micros);
+        lines.clear();
+        eols.clear();
+        views.clear();
+    };
+    for (const char* eol; beg<end; beg=eol+1){
+        eol=static_cast<const char*>(std::memchr(beg, '\n', end-beg));
+        if (!eol)
+            eol=end;
+        if (eol==beg || *beg=='#' || (eol-beg==1 && *beg=='\r'))
+            continue;
+        ++puzzles;
+        Board& board=boards[views.size()];
+        auto sTime=now();
+        bool isParsed=parsePuzzleLine(beg, eol, board);
+        if (isParsed && mIsLockstep){
+            lines.push_back(beg);
+            eols.push_back(eol);
+            views.push_back(board.view());
+            if (int(views.size())==groupSize)
+                solveGroup();
+            continue;
+        }
+        SolveResult result;
+        if (isParsed){
+            result=solveTable(board.view());
+        } else {
+            result.mStatus=SolveStatus::ImproperSize;
+            if (!views.empty())
+                solveGroup(); // lines are written in the input order
+        }
+        record(beg, eol, board.view(), result,
+               mIsTimed ? microsSince(sTime) : 0);
+    }
+    if (!views.empty())
+        solveGroup();
+    std::lock_guard<std::mutex> lck(mMutex);
+    mPuzzles+=puzzles;
+    mFailed+=failed;
+    mInvalid+=invalid;
+    for (int i=0; i<mBuckets; ++i)
+        mHistogram[i]+=histogram[i];
+    mStats.add(stats);
+}
+
+void printHistogram(const BatchSolver::Histogram& histogram){
+    std::cerr << "Solve time, us: puzzles" << std::endl;
+    for (int i=0; i<BatchSolver::mBuckets; ++i){
+        if (histogram[i]==0)
+            continue;
+        std::cerr << "  [" << (i ? 1LL<<(i-1) : 0) << ", " << (1LL<<i)
+                  << "): " << histogram[i] << std::endl;
+    }
+}
+
+void printStats(const SolverStats& stats){
+    std::cerr << "Nodes: " << stats.mNodes
+              << ", guesses: " << stats.mGuesses
+              << ", backtracks: " << stats.mBacktracks
+              << ", max depth: " << stats.mMaxDepth
+              << ", naked singles: " << stats.mNakedSingles
+              << ", hidden singles: " << stats.mHiddenSingles << "\n"
+              << "Time in init: " << stats.mInitTime
+              << "s., propagation: " << stats.mPropagateTime
+              << "s., search: " << stats.mSearchTime << "s." << std::endl;
+}
+
+void BatchSolver::workerFunction(){
+    const char *beg, *end;
+    std::size_t ind;
+    while (takeChunk(beg, end, ind)){
+        std::string out;
+        solveChunk(beg, end, out);
+        {
+            std::lock_guard<std::mutex> lck(mMutex);
+            mReady.emplace(ind, std::move(out));
+        }
+        mWriterCond.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lck(mMutex);
+        --mWorking;
+    }
+    mWriterCond.notify_one();
+}
+
+void BatchSolver::run(){
+    mWorking=mThrNum;
+    std::vector<std::thread> threads;
+    ThreadsGuard threadsJoiner(threads);
+    for (int i=0; i<mThrNum; ++i)
+        threads.push_back(std::thread(&BatchSolver::workerFunction, this));
+    std::unique_lock<std::mutex> lck(mMutex);
+    while (true){
+        mWriterCond.wait(lck, [this]{
+            return mWorking==0 || mReady.count(mNextToWrite);});
+        auto it=mReady.find(mNextToWrite);
+        if (it==mReady.end())
+            break; // all workers finished and everything is written
+        std::string out=std::move(it->second);
+        mReady.erase(it);
+        ++mNextToWrite;
+        lck.unlock();
+        mWorkerCond.notify_all();
+        mOut.write(out.data(), out.size());
+        lck.lock();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args;
+    Table::Engine engine=Table::Engine::Propagation;
+    Deductions deductions;
+    Branching branching=Branching::Mrv;
+    bool isArgsOk=true, isTimed=false, isLockstep=false;
+    long long cacheSize=0;
+    for (int i=1; i<argc; ++i){
+        std::string arg=argv[i];
+        if (arg=="--engine=dlx")
+            engine=Table::Engine::DancingLinks;
+        else if (arg=="--engine=propagation")
+            engine=Table::Engine::Propagation;
+        else if (arg=="--deductions")
+            deductions=Deductions::all();
+        else if (arg=="--branching=mrv")
+            branching=Branching::Mrv;
+        else if (arg=="--branching=degree")
+            branching=Branching::MrvDegree;
+        else if (arg=="--branching=lcv")
+            branching=Branching::LeastConstraining;
+        else if (arg=="--branching=restarts")
+            branching=Branching::RandomRestarts;
+        else if (arg=="--histogram")
+            isTimed=true;
+        else if (arg=="--lockstep")
+            isLockstep=true;
+        else if (arg=="--cache")
+            cacheSize=1<<16;
+        else if (arg.compare(0, 8, "--cache=")==0)
+            cacheSize=std::atoll(arg.c_str()+8);
+        else if (arg.compare(0, 2, "--")==0)
+            isArgsOk=false;
+        else
+            args.push_back(arg);
+    }
+    if (!isArgsOk || cacheSize<0 || args.empty() || args.size()>3){
+        std::cout << "Input should be:\n"
+                  << "<Program> [--engine=propagation|dlx] [--deductions] "
+                  << "[--branching=mrv|degree|lcv|restarts] "
+                  << "[--histogram] [--cache[=solutions]] [--lockstep] "
+                  << "<puzzles file> "
+                  << "[solutions file] [threads number]\n"
+                  << "Solutions go to stdout if file is not given or '-'.\n"
+                  << "--deductions enables pairs, triples, pointing, "
+                  << "claiming and X-Wing.\n"
+                  << "--branching chooses the guess cell and value order "
+                  << "(see Branching in sudoku.h).\n"
+                  << "--histogram prints distribution of solve times.\n"
+                  << "--cache keeps solutions (65536 by default) for "
+                  << "puzzles equivalent by symmetries.\n"
+                  << "--lockstep propagates 9x9 puzzles in SIMD batches, "
+                  << "solve times of a batch are its average." << std::endl;
+        return 1;
+    }
+    int thrNum=0;
+    if (args.size()==3)
+        thrNum=std::stoi(args[2]);
+    if (thrNum<=0 && (thrNum=std::thread::hardware_concurrency())==0)
+        thrNum=2; // in case info unavailable
+
+    try {
+        MappedFile inFile(args[0]);
+        std::ofstream outFile;
+        if (args.size()>1 && args[1]!="-"){
+            outFile.open(args[1], std::ios::binary);
+            if (!outFile){
+                std::cerr << "Unable to open " << args[1] << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out=outFile.is_open() ? outFile : std::cout;
+        std::ios::sync_with_stdio(false);
+
+        auto sTime=std::chrono::steady_clock::now();
+        std::unique_ptr<SolutionCache> cache;
+        BatchSolver solver(inFile, out, thrNum, engine, deductions);
+        solver.setTimed(isTimed);
+        solver.setBranching(branching);
+        solver.setLockstep(isLockstep);
+        if (cacheSize){
+            cache.reset(new SolutionCache(cacheSize));
+            solver.setCache(cache.get());
+        }
+        solver.run();
+        out.flush();
+        std::chrono::duration<double> durTime=
+            std::chrono::steady_clock::now()-sTime;
+
+        std::cerr << "Puzzles: " << solver.getPuzzlesNum()
+                  << ", unsolved: " << solver.getFailedNum()
+                  << " (invalid: " << solver.getInvalidNum() << ")"
+                  << ", threads: " << thrNum
+                  << ", time: " << durTime.count() << "s., "
+                  << solver.getPuzzlesNum()/durTime.count()
+                  << " puzzles/s." << std::endl;
+        if (cache)
+            std::cerr << "Cache hits: " << cache->getHitsNum()
+                      << ", misses: " << cache->getMissesNum() << std::endl;
+        if (isTimed)
+            printHistogram(solver.getHistogram());
+        if (SolverStats::mEnabled)
+            printStats(solver.getStats());
+        return solver.getFailedNum() ? 2 : 0;
+    } catch (std::exception& ex) {
+        std::cerr << "Error! : " << ex.what() << std::endl;
+        return 1;
+    }
+}
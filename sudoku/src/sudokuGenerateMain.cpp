@@ -0,0 +1,139 @@
+/**
+ * @brief Puzzle generator tool. Writes the given number of distinct
+ * puzzles with unique solutions, one per line (see puzzleio.h),
+ * generated on all cores. The same seed gives the same file for any
+ * threads number. Statistics with puzzles/second goes to stderr.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+#include "generator.h"
+#include "puzzleio.h"
+#include "sudoku.h"
+
+namespace {
+
+// puzzles generated (and kept in memory) at once
+const std::size_t puzzlesPerBlock=4096;
+
+bool parseOption(const std::string& arg, const std::string& name,
+                 std::string& value){
+    if (arg.compare(0, name.size(), name)!=0)
+        return false;
+    value=arg.substr(name.size());
+    return true;
+}
+
+bool parseDifficulty(const std::string& name, Difficulty& difficulty){
+    if (name=="any")
+        difficulty=Difficulty::Any;
+    else if (name=="easy")
+        difficulty=Difficulty::Easy;
+    else if (name=="medium")
+        difficulty=Difficulty::Medium;
+    else if (name=="hard")
+        difficulty=Difficulty::Hard;
+    else
+        return false;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args;
+    GeneratorOptions options;
+    bool isArgsOk=true;
+    try {
+        for (int i=1; i<argc; ++i){
+            std::string arg=argv[i], value;
+            if (parseOption(arg, "--box=", value))
+                options.mBox=std::stoi(value);
+            else if (parseOption(arg, "--clues=", value))
+                options.mClues=std::stoi(value);
+            else if (parseOption(arg, "--seed=", value))
+                options.mSeed=std::stoull(value);
+            else if (parseOption(arg, "--difficulty=", value))
+                isArgsOk=isArgsOk && parseDifficulty(value,
+                                                     options.mDifficulty);
+            else if (arg.compare(0, 2, "--")==0)
+                isArgsOk=false;
+            else
+                args.push_back(arg);
+        }
+    } catch (std::exception&) {
+        isArgsOk=false;
+    }
+    if (!isArgsOk || args.empty() || args.size()>3){
+        std::cout << "Input should be:\n"
+                  << "<Program> [--box=3] [--clues=N] "
+                  << "[--difficulty=any|easy|medium|hard] [--seed=N] "
+                  << "<puzzles number> [puzzles file] [threads number]\n"
+                  << "Puzzles go to stdout if file is not given or '-'.\n"
+                  << "--clues=0 (default) gives minimal puzzles.\n"
+                  << "easy - singles solve it, medium - needs pairs, "
+                  << "triples, pointing, claiming or X-Wing, "
+                  << "hard - needs guesses." << std::endl;
+        return 1;
+    }
+
+    try {
+        long long count=std::stoll(args[0]);
+        if (args.size()==3)
+            options.mThreadsNum=std::stoi(args[2]);
+        PuzzleGenerator generator(options);
+        std::ofstream outFile;
+        if (args.size()>1 && args[1]!="-"){
+            outFile.open(args[1], std::ios::binary);
+            if (!outFile){
+                std::cerr << "Unable to open " << args[1] << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out=outFile.is_open() ? outFile : std::cout;
+        std::ios::sync_with_stdio(false);
+
+        auto sTime=std::chrono::steady_clock::now();
+        // lines written so far, small boards repeat easily
+        std::unordered_set<std::string> written;
+        long long failed=0, repeated=0;
+        for (long long first=0; first<count; first+=puzzlesPerBlock){
+            std::size_t blockSize=std::min<long long>(puzzlesPerBlock,
+                                                      count-first);
+            std::vector<Board> puzzles=
+                    generator.generateBatch(first, blockSize);
+            failed+=blockSize-puzzles.size();
+            std::string block, line;
+            for (auto& puzzle: puzzles){
+                line.clear();
+                appendPuzzleLine(puzzle.view(), line);
+                if (written.insert(line).second)
+                    block+=line;
+                else
+                    ++repeated;
+            }
+            out.write(block.data(), block.size());
+        }
+        out.flush();
+        std::chrono::duration<double> durTime=
+            std::chrono::steady_clock::now()-sTime;
+
+        std::cerr << "Puzzles: " << written.size()
+                  << ", failed: " << failed
+                  << ", repeated: " << repeated
+                  << ", time: " << durTime.count() << "s., "
+                  << written.size()/durTime.count()
+                  << " puzzles/s." << std::endl;
+        return failed ? 2 : 0;
+    } catch (std::exception& ex) {
+        std::cerr << "Error! : " << ex.what() << std::endl;
+        return 1;
+    }
+}
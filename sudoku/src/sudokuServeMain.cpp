@@ -0,0 +1,688 @@
+/**
+ * @brief Sudoku solve daemon. Reads puzzles, one per line (see
+ * puzzleio.h), from stdin or from clients of a Unix socket and answers
+ * every line of a client in the order of its lines, so a shell pipeline
+ * pays the process startup once. Reading and parsing, solving on
+ * a pool of workers and formatting with writing are pipeline stages
+ * joined by bounded queues (boundedqueue.h).
+ * A line may give its own budgets after the puzzle:
+ * "<puzzle> nodes=N ms=T", the search of a puzzle which exceeds one
+ * is aborted. Solved puzzles are answered with the solution, the others
+ * with the line and "# <status>". Latency percentiles (from reading
+ * a line to writing its answer) go to stderr on shutdown: at the end
+ * of stdin or on SIGINT/SIGTERM.
+ *
+ * Author Mykola Fedorenko, email: stnikolay@ukr.net
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "boundedqueue.h"
+#include "puzzleio.h"
+#include "solutioncache.h"
+#include "sudoku.h"
+#include "workstealing.h"
+
+namespace {
+
+using Clock=std::chrono::steady_clock;
+
+// limits of the search of one puzzle, 0 - no limit
+struct Budget{
+    long long mNodes=0;
+    std::chrono::microseconds mTime{0};
+};
+
+/**
+ * @brief The LatencyHistogram class Log-linear buckets, 16 per power
+ * of two: a percentile is within 1/16 of the exact one at any scale
+ * and memory doesn't grow with the number of requests.
+ */
+class LatencyHistogram
+{
+public:
+    void add(long long micros){
+        ++mCount;
+        if (micros>mMax)
+            mMax=micros;
+        ++mBuckets[bucketOf(micros)];
+    }
+    long long getCount() const {return mCount;}
+    long long getMax() const {return mMax;}
+    // upper bound of the bucket of the part of requests
+    long long percentile(double part) const {
+        long long rank=std::max(1LL, (long long)std::ceil(part*mCount));
+        long long seen=0;
+        for (int b=0; b<mBucketsNum; ++b){
+            seen+=mBuckets[b];
+            if (seen>=rank)
+                return std::min(upperOf(b), mMax);
+        }
+        return mMax;
+    }
+private:
+    static const int mSubBits=4, mSub=1<<mSubBits;
+    static const int mBucketsNum=mSub*(64-mSubBits+1);
+    std::array<long long, mBucketsNum> mBuckets{{}};
+    long long mCount=0, mMax=0;
+
+    static int bucketOf(long long micros){
+        if (micros<mSub)
+            return micros<0 ? 0 : int(micros);
+        int exp=63-__builtin_clzll(micros);
+        return mSub*(exp-mSubBits+1)+int((micros>>(exp-mSubBits))&(mSub-1));
+    }
+    static long long upperOf(int bucket){
+        if (bucket<mSub)
+            return bucket;
+        int exp=bucket/mSub+mSubBits-1;
+        return ((mSub+bucket%mSub+1LL)<<(exp-mSubBits))-1;
+    }
+};
+
+struct Request;
+
+// input and output of one client, the output is touched by the writer
+// only, mInFlight is shared with the reader
+struct Client{
+    Client(int inFd, int outFd, bool isOwned)
+        : mInFd(inFd), mOutFd(outFd), mIsOwned(isOwned){}
+    int mInFd, mOutFd;
+    // socket clients are closed after the last answer
+    bool mIsOwned;
+    // mIsDirty - in the writer list of clients with answers to write,
+    // mIsEnded - all answers are in mOut
+    bool mIsBroken=false, mIsDirty=false, mIsEnded=false, mIsClosed=false;
+    // answers not written yet
+    std::string mOut;
+    // answers which wait for the previous ones
+    std::map<long long, std::unique_ptr<Request>> mReady;
+    long long mNextToWrite=0;
+    // requests read but not written yet
+    std::mutex mMutex;
+    std::condition_variable mWrittenCond;
+    long long mInFlight=0;
+};
+
+struct Request{
+    std::shared_ptr<Client> mClient;
+    long long mIndex=0;
+    // mIsEnd - the end of the client input, it follows all requests
+    bool mIsEnd=false, mIsParsed=false;
+    std::string mLine;
+    Budget mBudget;
+    // cells of the parsed board, solved in place
+    std::vector<std::uint8_t> mCells;
+    int mSide=0;
+    SolveResult mResult;
+    Clock::time_point mReadTime;
+    BoardView board(){return BoardView(mCells.data(), mSide);}
+};
+
+using RequestPtr=std::unique_ptr<Request>;
+
+/**
+ * @brief The SolveServer class Readers (a thread per client) parse lines
+ * into mSolveQueue, workers solve them into mDoneQueue, the writer puts
+ * answers of every client in order and writes them. A line which can't
+ * be parsed goes to mDoneQueue at once. Every client has at most
+ * mWindow requests in flight, so the reorder buffers are bounded too.
+ * The writer flushes when mDoneQueue is empty: answers of a burst go
+ * out in one write, a lonely request is not delayed. Socket clients
+ * don't block the writer: answers a client doesn't take stay in its
+ * mOut while the writer polls, and a client mBacklogBytes behind is
+ * disconnected, so it doesn't hold back the others.
+ */
+class SolveServer
+{
+public:
+    SolveServer(int thrNum, const Budget& budget,
+                const Deductions& deductions);
+    ~SolveServer();
+    SolveServer(const SolveServer& ss)=delete;
+    SolveServer& operator=(const SolveServer& ss)=delete;
+    void setCache(SolutionCache* cache){mCache=cache;}
+    // starts workers and the writer
+    void start();
+    // reader stage of a client on the calling thread, until the end
+    // of its input or stop()
+    void serveClient(int inFd, int outFd, bool isOwned);
+    // same on a new thread
+    void serveClientAsync(int fd);
+    // readers stop, requests read so far are still answered;
+    // async-signal-safe
+    void stop();
+    int getStopFd() const {return mStopPipe[0];}
+    // waits for readers, drains the pipeline and stops its threads
+    void finish();
+    void printReport(std::ostream& out) const;
+private:
+    static const long long mWindow=1024;
+    static const std::size_t mFlushBytes=1<<16;
+    static const std::size_t mBacklogBytes=1<<24;
+    int mThrNum;
+    Budget mBudget;
+    Deductions mDeductions;
+    SolutionCache* mCache=nullptr;
+    int mStopPipe[2];
+    // wakes the writer up from polling clients, written while
+    // mIsPolling is set
+    int mWakePipe[2];
+    std::atomic<bool> mIsPolling{false};
+    BoundedQueue<RequestPtr> mSolveQueue, mDoneQueue;
+    std::mutex mReadersMutex;
+    std::condition_variable mReadersCond;
+    int mReadersNum=0;
+    // writer only
+    LatencyHistogram mLatency;
+    long long mUnsolved=0, mInvalid=0, mAborted=0;
+    std::vector<std::thread> mThreads;
+    ThreadsGuard mThreadsJoiner;
+
+    // board is the parsing buffer of the reader
+    void parseRequest(const char* beg, const char* end, Board& board,
+                      Request& req) const;
+    void workerFunction();
+    void writerFunction();
+    void pushDone(RequestPtr req);
+    bool waitDone(RequestPtr& req,
+                  const std::vector<std::shared_ptr<Client>>& dirty);
+    void answer(Request& req, std::string& out);
+    void flush(Client& client);
+};
+
+SolveServer::SolveServer(int thrNum, const Budget& budget,
+                         const Deductions& deductions)
+    : mThrNum(thrNum), mBudget(budget), mDeductions(deductions),
+      mSolveQueue(64*thrNum), mDoneQueue(64*thrNum),
+      mThreadsJoiner(mThreads)
+{
+    if (pipe2(mStopPipe, O_CLOEXEC)<0)
+        throw std::runtime_error(std::string("Unable to create pipe: ")+
+                                 std::strerror(errno));
+    if (pipe2(mWakePipe, O_CLOEXEC|O_NONBLOCK)<0){
+        std::string msg=std::string("Unable to create pipe: ")+
+                std::strerror(errno);
+        close(mStopPipe[0]);
+        close(mStopPipe[1]);
+        throw std::runtime_error(msg);
+    }
+}
+
+SolveServer::~SolveServer(){
+    // threads left running by an error are joined by mThreadsJoiner
+    mSolveQueue.close();
+    mDoneQueue.close();
+    close(mStopPipe[0]);
+    close(mStopPipe[1]);
+    close(mWakePipe[0]);
+    close(mWakePipe[1]);
+}
+
+void SolveServer::start(){
+    for (int i=0; i<mThrNum; ++i)
+        mThreads.push_back(std::thread(&SolveServer::workerFunction, this));
+    mThreads.push_back(std::thread(&SolveServer::writerFunction, this));
+}
+
+void SolveServer::stop(){
+    char byte=0;
+    ssize_t res=write(mStopPipe[1], &byte, 1);
+    (void)res; // the pipe has been written already
+}
+
+void SolveServer::parseRequest(const char* beg, const char* end,
+                               Board& board, Request& req) const {
+    req.mLine.assign(beg, end);
+    req.mBudget=mBudget;
+    const char* eop=beg;
+    while (eop<end && *eop!=' ' && *eop!='\t')
+        ++eop;
+    if (!parsePuzzleLine(beg, eop, board))
+        return;
+    req.mSide=board.side();
+    req.mCells.assign(board[0], board[0]+req.mSide*req.mSide);
+    // budgets: nodes=N and ms=T separated by spaces
+    std::string options(eop, end);
+    const char* opt=options.c_str();
+    while (*opt){
+        if (*opt==' ' || *opt=='\t'){
+            ++opt;
+            continue;
+        }
+        char* rest=nullptr;
+        const char* value=nullptr;
+        if (std::strncmp(opt, "nodes=", 6)==0){
+            value=opt+6;
+            req.mBudget.mNodes=std::strtoll(value, &rest, 10);
+            if (req.mBudget.mNodes<0)
+                return;
+        } else if (std::strncmp(opt, "ms=", 3)==0){
+            value=opt+3;
+            double ms=std::strtod(value, &rest);
+            if (!(ms>=0))
+                return;
+            req.mBudget.mTime=std::chrono::microseconds(
+                        (long long)std::ceil(ms*1000));
+        } else
+            return;
+        if (rest==value || (*rest && *rest!=' ' && *rest!='\t'))
+            return;
+        opt=rest;
+    }
+    req.mIsParsed=true;
+}
+
+void SolveServer::serveClient(int inFd, int outFd, bool isOwned){
+    auto client=std::make_shared<Client>(inFd, outFd, isOwned);
+    std::string pending;
+    std::vector<char> buf(1<<16);
+    Board board;
+    long long index=0;
+    pollfd fds[2]={{inFd, POLLIN, 0}, {mStopPipe[0], POLLIN, 0}};
+    for (bool isEnd=false; !isEnd;){
+        if (poll(fds, 2, -1)<0){
+            if (errno==EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break; // unfinished line is dropped
+        ssize_t readNum=read(inFd, buf.data(), buf.size());
+        if (readNum<0 && (errno==EINTR || errno==EAGAIN))
+            continue;
+        if (readNum<=0){
+            isEnd=true;
+            if (!pending.empty() && pending.back()!='\n')
+                pending.push_back('\n');
+        } else
+            pending.append(buf.data(), readNum);
+        std::size_t beg=0;
+        for (std::size_t eol; (eol=pending.find('\n', beg))!=
+                std::string::npos; beg=eol+1){
+            const char* line=pending.data()+beg;
+            const char* eoLine=pending.data()+eol;
+            if (eoLine>line && eoLine[-1]=='\r')
+                --eoLine;
+            if (eoLine==line || *line=='#')
+                continue;
+            RequestPtr req(new Request);
+            req->mReadTime=Clock::now();
+            req->mClient=client;
+            req->mIndex=index++;
+            parseRequest(line, eoLine, board, *req);
+            {
+                std::unique_lock<std::mutex> lck(client->mMutex);
+                client->mWrittenCond.wait(lck, [&client]{
+                    return client->mInFlight<mWindow;});
+                ++client->mInFlight;
+            }
+            if (req->mIsParsed)
+                mSolveQueue.push(std::move(req));
+            else
+                pushDone(std::move(req));
+        }
+        pending.erase(0, beg);
+    }
+    RequestPtr end(new Request);
+    end->mClient=client;
+    end->mIndex=index;
+    end->mIsEnd=true;
+    pushDone(std::move(end));
+}
+
+void SolveServer::serveClientAsync(int fd){
+    {
+        std::lock_guard<std::mutex> lck(mReadersMutex);
+        ++mReadersNum;
+    }
+    std::thread([this, fd]{
+        serveClient(fd, fd, true);
+        std::lock_guard<std::mutex> lck(mReadersMutex);
+        if (--mReadersNum==0)
+            mReadersCond.notify_all();
+    }).detach();
+}
+
+void SolveServer::finish(){
+    {
+        std::unique_lock<std::mutex> lck(mReadersMutex);
+        mReadersCond.wait(lck, [this]{return mReadersNum==0;});
+    }
+    mSolveQueue.close();
+    for (int i=0; i<mThrNum; ++i)
+        mThreads[i].join();
+    mDoneQueue.close();
+    mThreads.back().join();
+}
+
+void SolveServer::workerFunction(){
+    RequestPtr req;
+    while (mSolveQueue.pop(req)){
+        Table table(req->board());
+        table.setDeductions(mDeductions);
+        table.setCache(mCache);
+        table.setNodeLimit(req->mBudget.mNodes);
+        table.setTimeLimit(req->mBudget.mTime);
+        req->mResult=table.trySolve();
+        pushDone(std::move(req));
+    }
+}
+
+void SolveServer::pushDone(RequestPtr req){
+    mDoneQueue.push(std::move(req));
+    if (mIsPolling){
+        char byte=0;
+        ssize_t res=write(mWakePipe[1], &byte, 1);
+        (void)res; // a full pipe wakes the writer up as well
+    }
+}
+
+/**
+ * @brief SolveServer::waitDone Waits until a client of dirty can take
+ * more answers or a request is done.
+ * @return true if req is taken from mDoneQueue.
+ */
+bool SolveServer::waitDone(RequestPtr& req,
+                           const std::vector<std::shared_ptr<Client>>& dirty){
+    std::vector<pollfd> fds;
+    fds.push_back({mWakePipe[0], POLLIN, 0});
+    for (auto& client: dirty)
+        fds.push_back({client->mOutFd, POLLOUT, 0});
+    // the flag is set before the queue is checked, so a request pushed
+    // after the check writes to the pipe
+    mIsPolling=true;
+    bool isTaken=mDoneQueue.tryPop(req);
+    if (!isTaken)
+        poll(fds.data(), fds.size(), -1); // EINTR is a wake up too
+    mIsPolling=false;
+    char buf[64];
+    while (read(mWakePipe[0], buf, sizeof(buf))>0){}
+    return isTaken;
+}
+
+void SolveServer::answer(Request& req, std::string& out){
+    if (req.mIsParsed && req.mResult.isSolved()){
+        appendPuzzleLine(req.board(), out);
+    } else {
+        ++mUnsolved;
+        out+=req.mLine;
+        if (!req.mIsParsed){
+            ++mInvalid;
+            out+=" # invalid";
+        } else if (req.mResult.mStatus==SolveStatus::Aborted){
+            ++mAborted;
+            out+=" # aborted";
+        } else if (req.mResult.mStatus==SolveStatus::ImproperClue){
+            ++mInvalid;
+            out+=" # improper-clue "+std::to_string(req.mResult.mRow)+" "+
+                    std::to_string(req.mResult.mCol);
+        } else if (req.mResult.mStatus==SolveStatus::ImproperSize){
+            ++mInvalid;
+            out+=" # improper-size";
+        } else
+            out+=" # no-solution";
+        out.push_back('\n');
+    }
+    mLatency.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                     Clock::now()-req.mReadTime).count());
+}
+
+// writes as much as the client takes without waiting, an ended client
+// is closed after its last answer
+void SolveServer::flush(Client& client){
+    std::size_t done=0;
+    while (!client.mIsBroken && done<client.mOut.size()){
+        ssize_t res=write(client.mOutFd, client.mOut.data()+done,
+                          client.mOut.size()-done);
+        if (res<0 && errno==EINTR)
+            continue;
+        if (res<0 && (errno==EAGAIN || errno==EWOULDBLOCK))
+            break;
+        if (res<=0)
+            client.mIsBroken=true; // answers of a gone client are dropped
+        else
+            done+=res;
+    }
+    client.mOut.erase(0, done);
+    if (!client.mIsBroken && client.mOut.size()>mBacklogBytes){
+        // it doesn't read its answers, its reader stops too
+        shutdown(client.mOutFd, SHUT_RDWR);
+        client.mIsBroken=true;
+    }
+    if (client.mIsBroken)
+        client.mOut.clear();
+    if (client.mIsEnded && client.mOut.empty() && !client.mIsClosed){
+        if (client.mIsOwned)
+            close(client.mOutFd);
+        client.mIsClosed=client.mIsBroken=true;
+    }
+}
+
+void SolveServer::writerFunction(){
+    std::vector<std::shared_ptr<Client>> dirty;
+    RequestPtr req;
+    while (true){
+        if (!mDoneQueue.tryPop(req)){
+            for (auto& client: dirty){
+                flush(*client);
+                client->mIsDirty=!client->mOut.empty();
+            }
+            dirty.erase(std::remove_if(dirty.begin(), dirty.end(),
+                            [](const std::shared_ptr<Client>& client){
+                                return !client->mIsDirty;}),
+                        dirty.end());
+            // answers of the clients left wait until they read
+            if (dirty.empty()){
+                if (!mDoneQueue.pop(req))
+                    break;
+            } else if (!waitDone(req, dirty))
+                continue;
+        }
+        std::shared_ptr<Client> client=req->mClient;
+        long long index=req->mIndex;
+        client->mReady.emplace(index, std::move(req));
+        long long written=0;
+        for (auto it=client->mReady.begin(); it!=client->mReady.end()
+             && it->first==client->mNextToWrite;
+             it=client->mReady.erase(it)){
+            if (it->second->mIsEnd){
+                client->mIsEnded=true;
+                continue;
+            }
+            answer(*it->second, client->mOut);
+            ++client->mNextToWrite;
+            ++written;
+        }
+        if (written){
+            {
+                std::lock_guard<std::mutex> lck(client->mMutex);
+                client->mInFlight-=written;
+            }
+            client->mWrittenCond.notify_one();
+        }
+        if (client->mOut.size()>=mFlushBytes || client->mIsEnded)
+            flush(*client);
+        if (!client->mOut.empty() && !client->mIsDirty){
+            client->mIsDirty=true;
+            dirty.push_back(client);
+        }
+    }
+}
+
+void SolveServer::printReport(std::ostream& out) const {
+    out << "Requests: " << mLatency.getCount()
+        << ", unsolved: " << mUnsolved << " (invalid: " << mInvalid
+        << ", aborted: " << mAborted << ")\n"
+        << "Latency, us: p50 " << mLatency.percentile(0.5)
+        << ", p90 " << mLatency.percentile(0.9)
+        << ", p99 " << mLatency.percentile(0.99)
+        << ", max " << mLatency.getMax() << std::endl;
+}
+
+int listenSocket(const std::string& path){
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family=AF_UNIX;
+    if (path.size()>=sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path is too long: "+path);
+    std::strcpy(addr.sun_path, path.c_str());
+    // a socket left by a previous run, other files are not touched
+    struct stat pathStat;
+    if (lstat(path.c_str(), &pathStat)==0 && S_ISSOCK(pathStat.st_mode))
+        unlink(path.c_str());
+    int fd=socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+    if (fd<0 || bind(fd, reinterpret_cast<sockaddr*>(&addr),
+                     sizeof(addr))<0 || listen(fd, 64)<0){
+        std::string msg="Unable to listen on "+path+": "+
+                std::strerror(errno);
+        if (fd>=0)
+            close(fd);
+        throw std::runtime_error(msg);
+    }
+    return fd;
+}
+
+void acceptClients(SolveServer& server, int listenFd){
+    pollfd fds[2]={{listenFd, POLLIN, 0}, {server.getStopFd(), POLLIN, 0}};
+    while (true){
+        if (poll(fds, 2, -1)<0){
+            if (errno==EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+        // a client which doesn't read its answers must not block the
+        // writer
+        int fd=accept4(listenFd, nullptr, nullptr,
+                       SOCK_CLOEXEC|SOCK_NONBLOCK);
+        if (fd>=0)
+            server.serveClientAsync(fd);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args;
+    Budget budget;
+    Deductions deductions;
+    std::string socketPath;
+    bool isArgsOk=true;
+    long long cacheSize=0;
+    for (int i=1; i<argc; ++i){
+        std::string arg=argv[i];
+        if (arg.compare(0, 9, "--socket=")==0)
+            socketPath=arg.substr(9);
+        else if (arg.compare(0, 8, "--nodes=")==0)
+            isArgsOk&=(budget.mNodes=std::atoll(arg.c_str()+8))>=0;
+        else if (arg.compare(0, 10, "--time-ms=")==0){
+            double ms=std::atof(arg.c_str()+10);
+            isArgsOk&=ms>=0;
+            budget.mTime=std::chrono::microseconds(
+                        (long long)std::ceil(ms*1000));
+        } else if (arg=="--deductions")
+            deductions=Deductions::all();
+        else if (arg=="--cache")
+            cacheSize=1<<16;
+        else if (arg.compare(0, 8, "--cache=")==0)
+            cacheSize=std::atoll(arg.c_str()+8);
+        else if (arg.compare(0, 2, "--")==0)
+            isArgsOk=false;
+        else
+            args.push_back(arg);
+    }
+    if (!isArgsOk || cacheSize<0 || args.size()>1){
+        std::cout << "Input should be:\n"
+                  << "<Program> [--socket=path] [--nodes=N] [--time-ms=T] "
+                  << "[--deductions] [--cache[=solutions]] "
+                  << "[threads number]\n"
+                  << "Puzzles are read from stdin, or from clients of the "
+                  << "Unix socket, until its end or SIGINT/SIGTERM.\n"
+                  << "A line may override budgets: <puzzle> nodes=N ms=T, "
+                  << "0 - no limit.\n"
+                  << "Unsolved puzzles are answered with the line and "
+                  << "# <status>." << std::endl;
+        return 1;
+    }
+    int thrNum=0;
+    if (args.size()==1)
+        thrNum=std::stoi(args[0]);
+    if (thrNum<=0 && (thrNum=std::thread::hardware_concurrency())==0)
+        thrNum=2; // in case info unavailable
+
+    // signals are taken by sigwait() of one thread, writes to gone
+    // clients fail with EPIPE instead
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<SolutionCache> cache;
+    std::unique_ptr<SolveServer> server;
+    try {
+        server.reset(new SolveServer(thrNum, budget, deductions));
+    } catch (std::exception& ex) {
+        std::cerr << "Error! : " << ex.what() << std::endl;
+        return 1;
+    }
+    if (cacheSize){
+        cache.reset(new SolutionCache(cacheSize));
+        server->setCache(cache.get());
+    }
+    // on a normal end it gets SIGTERM from main, so it can be joined
+    std::thread signalThread([&server, stopSignals]{
+        int sig;
+        if (sigwait(&stopSignals, &sig)==0)
+            server->stop();
+    });
+    int res=0;
+    try {
+        server->start();
+        if (socketPath.empty()){
+            server->serveClient(STDIN_FILENO, STDOUT_FILENO, false);
+        } else {
+            int listenFd=listenSocket(socketPath);
+            acceptClients(*server, listenFd);
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+        server->finish();
+        server->printReport(std::cerr);
+        if (cache)
+            std::cerr << "Cache hits: " << cache->getHitsNum()
+                      << ", misses: " << cache->getMissesNum() << std::endl;
+    } catch (std::exception& ex) {
+        std::cerr << "Error! : " << ex.what() << std::endl;
+        res=1;
+    }
+    pthread_kill(signalThread.native_handle(), SIGTERM);
+    signalThread.join();
+    return res;
+}
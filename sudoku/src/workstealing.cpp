@@ -0,0 +1,115 @@
+/* Work stealing thread pool implementation
+* author Mykola Fedorenko stnikolay@ukr.net
+*/
+#include "workstealing.h"
+
+namespace {
+// pool and deque index of the current thread if it is a worker
+thread_local WorkStealingPool* tPool=nullptr;
+thread_local int tQueueInd=-1;
+}
+
+WorkStealingPool::WorkStealingPool(int thrNum)
+    : mDone(false), mQueued(0), mUnfinished(0), mNextQueue(0),
+      mThreadsJoiner(mThreads)
+{
+    if (thrNum<=0 && (thrNum=std::thread::hardware_concurrency())==0){
+        thrNum=2; // in case info unavailable
+    }
+    for (int i=0; i<thrNum; ++i)
+        mQueues.emplace_back(new WorkQueue);
+    try {
+        for (int i=0; i<thrNum; ++i)
+            mThreads.push_back(
+                std::thread(&WorkStealingPool::threadFunction, this, i));
+    } catch (...) {
+        mDone=true;
+        mCondition.notify_all();
+        throw;
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lck(mMutex);
+        mDone=true;
+    }
+    mCondition.notify_all();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    int ind=(tPool==this) ? tQueueInd
+                          : int(mNextQueue++%mQueues.size());
+    ++mUnfinished;
+    try {
+        std::lock_guard<std::mutex> lck(mQueues[ind]->mMutex);
+        mQueues[ind]->mTasks.push_back(std::move(task));
+    } catch (...) {
+        // the task isn't queued, wait() must not wait for it
+        if (--mUnfinished==0){
+            std::lock_guard<std::mutex> lck(mMutex);
+            mIdleCondition.notify_all();
+        }
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> lck(mMutex);
+        ++mQueued;
+    }
+    mCondition.notify_one();
+}
+
+bool WorkStealingPool::popTask(int ind, Task& task)
+{
+    {
+        // own tasks, newest first
+        WorkQueue& own=*mQueues[ind];
+        std::lock_guard<std::mutex> lck(own.mMutex);
+        if (!own.mTasks.empty()){
+            task=std::move(own.mTasks.back());
+            own.mTasks.pop_back();
+            --mQueued;
+            return true;
+        }
+    }
+    // steal the oldest task of somebody else
+    for (std::size_t i=1; i<mQueues.size(); ++i){
+        WorkQueue& victim=*mQueues[(ind+i)%mQueues.size()];
+        std::lock_guard<std::mutex> lck(victim.mMutex);
+        if (!victim.mTasks.empty()){
+            task=std::move(victim.mTasks.front());
+            victim.mTasks.pop_front();
+            --mQueued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::threadFunction(int ind)
+{
+    tPool=this;
+    tQueueInd=ind;
+    Task curTask;
+    while (!mDone){
+        if (popTask(ind, curTask)){
+            curTask();
+            curTask=nullptr;
+            if (--mUnfinished==0){
+                std::lock_guard<std::mutex> lck(mMutex);
+                mIdleCondition.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lck(mMutex);
+        mCondition.wait(lck, [this]{ return mDone || mQueued>0;});
+    }
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lck(mMutex);
+    mIdleCondition.wait(lck, [this]{ return mUnfinished==0;});
+}
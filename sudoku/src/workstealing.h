@@ -0,0 +1,79 @@
+/*
+ * workstealing.h
+ *
+ * Work stealing thread pool used by the parallel search.
+ * Every worker has its own deque: tasks submitted from a worker go
+ * to the back of its deque and are taken from the back again
+ * (depth first), idle workers steal from the front of other deques,
+ * where the oldest and usually the largest subtrees are.
+ *
+ */
+
+#ifndef SUDOKU_WORKSTEALING_H
+#define SUDOKU_WORKSTEALING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The ThreadsGuard class Join threads during destruction
+ * must be put in the rigth place in the owner members declarations
+ * (during destruction threads must be destroyed after it)
+ */
+class ThreadsGuard
+{
+public:
+    explicit
+    ThreadsGuard(std::vector<std::thread>& vec):mThrVec(vec){}
+    ThreadsGuard(const ThreadsGuard& tg)=delete;
+    ThreadsGuard& operator=(const ThreadsGuard& tg)=delete;
+    ~ThreadsGuard(){
+        for (auto& thr: mThrVec)
+            if (thr.joinable())
+                thr.join();
+    }
+private:
+    std::vector<std::thread>& mThrVec;
+};
+
+class WorkStealingPool
+{
+public:
+    using Task=std::function<void()>;
+    explicit
+    WorkStealingPool(int thrNum=0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool& wsp)=delete;
+    WorkStealingPool& operator=(const WorkStealingPool& wsp)=delete;
+
+    // from a worker of this pool task goes to its own deque,
+    // otherwise deques are filled in turn
+    void submit(Task task);
+    // blocks until all submitted tasks (and their subtasks) finish
+    void wait();
+    int getThreadsNum() const {return mThreads.size();}
+private:
+    struct WorkQueue{
+        std::mutex mMutex;
+        std::deque<Task> mTasks;
+    };
+    std::atomic_bool mDone;
+    std::atomic<long> mQueued, mUnfinished;
+    std::atomic<unsigned> mNextQueue;
+    std::vector<std::unique_ptr<WorkQueue>> mQueues;
+    std::mutex mMutex;
+    std::condition_variable mCondition, mIdleCondition;
+    std::vector<std::thread> mThreads;
+    ThreadsGuard mThreadsJoiner;
+
+    bool popTask(int ind, Task& task);
+    void threadFunction(int ind);
+};
+
+#endif // SUDOKU_WORKSTEALING_H
@@ -5,6 +5,23 @@
 #include "gtest/gtest.h"
 
 #include "sudoku.h"
+#include "puzzleio.h"
+#include "boundedqueue.h"
+#include "canonical.h"
+#include "dlx.h"
+#include "generator.h"
+#include "hiddensimd.h"
+#include "lockstep.h"
+#include "solutioncache.h"
+#include "workstealing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include <sys/resource.h>
+#include <unistd.h>
 
 TEST(Sudoku, solve1)
 {
@@ -137,25 +154,1117 @@ TEST(Sudoku, solve3)
     ASSERT_EQ(e, table.sudoku());
 }
 
-// TEST(Sudoku, solve4)
-// {
-//     std::vector<Row> t = {
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
+// needs deep search, every wrong guess has to be undone exactly
+TEST(Sudoku, solveHardest)
+{
+    std::vector<Row> t = {
+        {8, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 3,   6, 0, 0,   0, 0, 0},
+        {0, 7, 0,   0, 9, 0,   2, 0, 0},
+
+        {0, 5, 0,   0, 0, 7,   0, 0, 0},
+        {0, 0, 0,   0, 4, 5,   7, 0, 0},
+        {0, 0, 0,   1, 0, 0,   0, 3, 0},
+
+        {0, 0, 1,   0, 0, 0,   0, 6, 8},
+        {0, 0, 8,   5, 0, 0,   0, 1, 0},
+        {0, 9, 0,   0, 0, 0,   4, 0, 0},
+    };
+
+    std::vector<Row> e = {
+        {8, 1, 2,   7, 5, 3,   6, 4, 9},
+        {9, 4, 3,   6, 8, 2,   1, 7, 5},
+        {6, 7, 5,   4, 9, 1,   2, 8, 3},
+
+        {1, 5, 4,   2, 3, 7,   8, 9, 6},
+        {3, 6, 9,   8, 4, 5,   7, 2, 1},
+        {2, 8, 7,   1, 6, 9,   5, 3, 4},
+
+        {5, 2, 1,   9, 7, 4,   3, 6, 8},
+        {4, 3, 8,   5, 2, 6,   9, 1, 7},
+        {7, 9, 6,   3, 1, 8,   4, 5, 2},
+    };
+
+    Table table(t);
+
+    ASSERT_EQ(e, table.sudoku());
+}
+
+// checks that s is a complete sudoku which keeps all clues of t
+bool isValidSolution(const std::vector<Row>& t, const std::vector<Row>& s)
+{
+    int n = t.size();
+    int box = 1;
+    while (box*box < n) ++box;
+    if (int(s.size()) != n)
+        return false;
+    for (int i = 0; i < n; ++i)
+    {
+        std::vector<int> row(n+1), col(n+1), blk(n+1);
+        for (int j = 0; j < n; ++j)
+        {
+            if (t[i][j] && t[i][j] != s[i][j])
+                return false;
+            int r = s[i][j], c = s[j][i];
+            int b = s[(i/box)*box + j/box][(i%box)*box + j%box];
+            if (r < 1 || r > n || c < 1 || c > n || b < 1 || b > n)
+                return false;
+            if (row[r]++ || col[c]++ || blk[b]++)
+                return false;
+        }
+    }
+    return true;
+}
+
+// solved board of the given order with every 'step'-th cell removed
+std::vector<Row> patternPuzzle(int order, int step)
+{
+    int n = order*order;
+    std::vector<Row> t(n, Row(n));
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            t[i][j] = (order*(i%order) + i/order + j) % n + 1;
+    for (int k = 0; k < n*n; k += step)
+        t[k/n][k%n] = 0;
+    return t;
+}
+
+TEST(BitMask, fixedWidthOperations)
+{
+    BitMask<9> m;
+    EXPECT_EQ(sizeof(m), sizeof(std::uint16_t));
+    EXPECT_EQ(9, m.getBitsNum());
+    EXPECT_EQ(9, m.getIndex());
+    EXPECT_EQ(1, m.getLowIndex());
+    m.unSet(9).unSet(1);
+    EXPECT_EQ(7, m.getBitsNum());
+    EXPECT_EQ(8, m.getIndex());
+    EXPECT_EQ(2, m.getLowIndex());
+    EXPECT_FALSE(m.getBit(1));
+    EXPECT_TRUE((m & BitMask<9>::single(5)).any());
+    EXPECT_FALSE((m & BitMask<9>::single(1)).any());
+
+    EXPECT_EQ(sizeof(BitMask<25>), sizeof(std::uint32_t));
+    EXPECT_EQ(sizeof(BitMask<64>), sizeof(std::uint64_t));
+    BitMask<64> w;
+    EXPECT_EQ(64, w.getBitsNum());
+    EXPECT_EQ(64, w.getIndex());
+    EXPECT_EQ(0, (~w).getBitsNum());
+
+    // multiword mask, first word empty
+    BitMask<100> big;
+    for (int i = 1; i <= 64; ++i)
+        big.unSet(i);
+    EXPECT_EQ(36, big.getBitsNum());
+    EXPECT_EQ(100, big.getIndex());
+    EXPECT_EQ(65, big.getLowIndex());
+    EXPECT_EQ(64, (~big).getBitsNum());
+}
+
+// compares kernel with a plain count of cells having every bit
+template <typename Word>
+void checkHiddenKernel(int unitsNum)
+{
+    std::vector<Word> lanes(unitsNum*unitsNum+hiddenKernelPad);
+    std::vector<Word> once(unitsNum+hiddenKernelPad);
+    std::vector<Word> seen(unitsNum+hiddenKernelPad);
+    std::uint64_t rnd = 12345;
+    Word bits = Word(~Word(0)) >> (8*sizeof(Word)-unitsNum);
+    for (auto& lane: lanes){
+        rnd = rnd*6364136223846793005ULL+1442695040888963407ULL;
+        // sparse masks so that many bits are seen exactly once
+        lane = Word(rnd>>7) & Word(rnd>>13) & Word(rnd>>3) & bits;
+    }
+    hiddenSinglesKernel(lanes.data(), unitsNum, unitsNum,
+                        once.data(), seen.data());
+    for (int u = 0; u < unitsNum; ++u){
+        Word expOnce = 0, expSeen = 0;
+        for (int bit = 0; bit < unitsNum; ++bit){
+            int num = 0;
+            for (int k = 0; k < unitsNum; ++k)
+                num += (lanes[k*unitsNum+u]>>bit)&1;
+            if (num == 1)
+                expOnce |= Word(1)<<bit;
+            if (num)
+                expSeen |= Word(1)<<bit;
+        }
+        EXPECT_EQ(expOnce, once[u]) << hiddenSinglesIsa() << " unit " << u;
+        EXPECT_EQ(expSeen, seen[u]) << hiddenSinglesIsa() << " unit " << u;
+    }
+}
+
+TEST(HiddenSingles, kernelMatchesScalar)
+{
+    checkHiddenKernel<std::uint16_t>(9);
+    checkHiddenKernel<std::uint16_t>(16);
+    checkHiddenKernel<std::uint32_t>(25);
+    checkHiddenKernel<std::uint64_t>(36);
+    checkHiddenKernel<std::uint64_t>(64);
+}
+
+TEST(Sudoku, solveOtherOrders)
+{
+    for (int order = 2; order <= maxBoardBox; ++order)
+    {
+        std::vector<Row> t = patternPuzzle(order, 2);
+        Table table(t);
+        EXPECT_TRUE(isValidSolution(t, table.sudoku())) << "order " << order;
+    }
+    // large empty boards need many guesses
+    for (int order = 6; order <= maxBoardBox; ++order)
+    {
+        std::vector<Row> t(order*order, Row(order*order));
+        Table table(t);
+        EXPECT_TRUE(isValidSolution(t, table.sudoku())) << "order " << order;
+    }
+}
+
+TEST(Sudoku, solve4)
+{
+    std::vector<Row> t = {
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 0,   0, 0, 0,   0, 0, 0},
+    };
+
+    Table table(t);
+    ASSERT_TRUE(isValidSolution(t, table.sudoku()));
+}
+
+TEST(Sudoku, solveParallel)
+{
+    std::vector<Row> t = {
+        {8, 0, 0,   0, 0, 0,   0, 0, 0},
+        {0, 0, 3,   6, 0, 0,   0, 0, 0},
+        {0, 7, 0,   0, 9, 0,   2, 0, 0},
+
+        {0, 5, 0,   0, 0, 7,   0, 0, 0},
+        {0, 0, 0,   0, 4, 5,   7, 0, 0},
+        {0, 0, 0,   1, 0, 0,   0, 3, 0},
+
+        {0, 0, 1,   0, 0, 0,   0, 6, 8},
+        {0, 0, 8,   5, 0, 0,   0, 1, 0},
+        {0, 9, 0,   0, 0, 0,   4, 0, 0},
+    };
+    std::vector<Row> serial = Table(t).sudoku();
+    for (int thrNum : {2, 4})
+    {
+        Table table(t);
+        table.setThreadsNum(thrNum);
+        EXPECT_EQ(serial, table.sudoku()) << thrNum << " threads";
+    }
+
+    // many solutions, any of them stops the search
+    for (int order = 3; order <= 5; ++order)
+    {
+        std::vector<Row> e(order*order, Row(order*order));
+        for (int i = 0; i < order; ++i)
+            e[0][i] = i + 1;
+        Table table(e);
+        table.setThreadsNum(4);
+        EXPECT_TRUE(isValidSolution(e, table.sudoku())) << "order " << order;
+    }
+}
+
+// the board of solveHardest, one-line format
+const std::string hardestPuzzle =
+    "8..........36......7..9.2...5...7.......457.....1...3."
+    "..1....68..85...1..9....4..";
+
+// puzzles with unique solutions, one-line format
+std::vector<std::string> uniquePuzzles =
+{
+    "6..2.4...4..5..7.........8.....8..1...5.3....2.........8..7.......6..2...1.......",
+    "...72..........83..9.......7..4..1..3.1...........64...6.....52...1............7.",
+    hardestPuzzle,
+    "1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1",
+    "1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+};
+
+TEST(Sudoku, concurrentTables)
+{
+    // tables of different sizes solved on several threads at once
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    for (int thr = 0; thr < 4; ++thr)
+    {
+        threads.push_back(std::thread([thr, &failed]{
+            for (int k = 0; k < 20; ++k)
+            {
+                std::vector<Row> t = patternPuzzle(3 + (thr+k)%3, 2 + k%2);
+                std::vector<Row> result;
+                Table table(t);
+                if (!table.solve(result) || !isValidSolution(t, result))
+                    ++failed;
+            }
+        }));
+    }
+    for (auto& th : threads)
+        th.join();
+    EXPECT_EQ(0, failed);
+}
+
+TEST(Sudoku, dancingLinksCrossCheck)
+{
+    for (auto& line : uniquePuzzles)
+    {
+        std::vector<Row> t;
+        ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+        std::vector<Row> e = Table(t).sudoku();
+        ASSERT_TRUE(isValidSolution(t, e)) << line;
+
+        Table table(t);
+        table.setEngine(Table::Engine::DancingLinks);
+        EXPECT_EQ(e, table.sudoku()) << line;
+    }
+    for (int order = 2; order <= maxBoardBox; ++order)
+    {
+        std::vector<Row> t = patternPuzzle(order, 3);
+        Table table(t);
+        table.setEngine(Table::Engine::DancingLinks);
+        EXPECT_TRUE(isValidSolution(t, table.sudoku())) << "order " << order;
+    }
+
+    // no solution, but no contradiction among clues either
+    std::vector<Row> t(4, Row(4));
+    t[0][0] = 1;
+    t[1][2] = 1;
+    t[2][1] = 2;
+    t[2][3] = 3;
+    std::vector<Row> board = t;
+    EXPECT_FALSE(solveDancingLinks(board));
+    EXPECT_EQ(t, board);
+
+    t[3][0] = 1;
+    EXPECT_THROW(solveDancingLinks(t), ImproperAssignmentException);
+}
+
+TEST(Sudoku, branchingPolicies)
+{
+    // every policy finds the unique solutions and counts them right,
+    // serial and parallel
+    for (auto branching : {Branching::Mrv, Branching::MrvDegree,
+                           Branching::LeastConstraining,
+                           Branching::RandomRestarts})
+    {
+        for (auto& line : uniquePuzzles)
+        {
+            std::vector<Row> t, e;
+            ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+            ASSERT_TRUE(Table(t).solve(e));
+            for (int thrNum : {1, 4})
+            {
+                Table table(t);
+                table.setBranching(branching);
+                table.setThreadsNum(thrNum);
+                EXPECT_EQ(e, table.sudoku()) << line;
+                Table counter(t);
+                counter.setBranching(branching);
+                counter.setThreadsNum(thrNum);
+                EXPECT_EQ(1, counter.countSolutions()) << line;
+            }
+        }
+        for (int order = 2; order <= 5; ++order)
+        {
+            std::vector<Row> t = patternPuzzle(order, 2);
+            Table table(t);
+            table.setBranching(branching);
+            EXPECT_TRUE(isValidSolution(t, table.sudoku())) << "order " << order;
+        }
+    }
+
+    // restarts keep counting nodes for the node limit
+    const std::string& line = uniquePuzzles[0];
+    std::vector<Row> t;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    Table table(t);
+    table.setBranching(Branching::RandomRestarts);
+    table.setNodeLimit(2);
+    EXPECT_EQ(SolveStatus::Aborted, table.trySolve().mStatus);
+    EXPECT_TRUE(table.isAborted());
+}
+
+TEST(Sudoku, deductions)
+{
+    // every rule alone and all of them give the same unique solutions,
+    // every rule eliminates something on these puzzles
+    std::array<long long, Deductions::RulesNum> eliminations{{}};
+    for (auto& line : uniquePuzzles)
+    {
+        std::vector<Row> t, plain;
+        ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+        ASSERT_TRUE(Table(t).solve(plain));
+        for (int r = -1; r < Deductions::RulesNum; ++r)
+        {
+            Deductions d = r < 0 ? Deductions::all()
+                : Deductions().enable(Deductions::Rule(r));
+            std::vector<Row> result;
+            Table table(t);
+            table.setDeductions(d);
+            EXPECT_TRUE(table.solve(result)) << "rule " << r;
+            EXPECT_EQ(plain, result) << "rule " << r;
+            for (int other = 0; other < Deductions::RulesNum; ++other)
+            {
+                long long num = table.getDeductions().getEliminations(
+                            Deductions::Rule(other));
+                if (other == r)
+                    eliminations[r] += num;
+                else if (r >= 0)
+                {
+                    EXPECT_EQ(0, num) << "rule " << other;
+                }
+            }
+        }
+    }
+    for (int r = 0; r < Deductions::RulesNum; ++r)
+        EXPECT_GT(eliminations[r], 0) << "rule " << r;
+}
+
+TEST(Sudoku, solverStats)
+{
+    std::vector<Row> t;
+    const std::string& line = uniquePuzzles[0];
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    std::vector<Row> result;
+    Table table(t);
+    ASSERT_TRUE(table.solve(result));
+    const SolverStats& stats = table.getStats();
+    int clues = 0;
+    for (auto& row : t)
+        for (int val : row)
+            clues += val != 0;
+    if (!SolverStats::mEnabled)
+    {
+        EXPECT_EQ(0, stats.mNodes);
+        EXPECT_EQ(0, stats.mSearchTime);
+        return;
+    }
+    EXPECT_GT(stats.mNodes, 0);
+    EXPECT_GE(stats.mGuesses, stats.mNodes);
+    // guesses kept are the path to the solution
+    long long kept = stats.mGuesses - stats.mBacktracks;
+    EXPECT_GT(kept, 0);
+    EXPECT_LE(kept, stats.mMaxDepth);
+    // every cell is a clue, a guess or a single
+    EXPECT_LE(81 - clues - kept, stats.mNakedSingles + stats.mHiddenSingles);
+    EXPECT_GT(stats.mSearchTime, 0);
+    EXPECT_GE(stats.mSearchTime, stats.mPropagateTime - stats.mInitTime);
+}
+
+TEST(Sudoku, countSolutions)
+{
+    for (auto& line : uniquePuzzles)
+    {
+        std::vector<Row> t;
+        ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+        EXPECT_EQ(1, Table(t).countSolutions()) << line;
+        Table table(t);
+        table.setThreadsNum(3);
+        EXPECT_EQ(1, table.countSolutions(2)) << line;
+    }
 
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
+    // solution of solve1 without a 2/3 rectangle, it has two solutions
+    std::string line =
+        "678.9415.423518769159.6748.367982514845136927291745836"
+        "582473691934651278716829345";
+    std::vector<Row> t;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    EXPECT_EQ(2, Table(t).countSolutions(10));
+    EXPECT_EQ(1, Table(t).countSolutions(1));
+    // solve2 with one clue less
+    line = "....62.........8...........53.8............67.........."
+           "..3..14...6.4.5...72......";
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    EXPECT_EQ(10, Table(t).countSolutions(10));
 
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//         {0, 0, 0,   0, 0, 0,   0, 0, 0},
-//     };
+    // 4x4 board with one clue has 288/4=72 completions, stop early
+    std::vector<Row> small(4, Row(4));
+    small[0][0] = 1;
+    EXPECT_EQ(72, Table(small).countSolutions(1000));
+    EXPECT_EQ(5, Table(small).countSolutions(5));
+    for (int thrNum : {2, 4})
+    {
+        Table table(small);
+        table.setThreadsNum(thrNum);
+        EXPECT_EQ(72, table.countSolutions(1000));
+        EXPECT_EQ(10, table.countSolutions(10));
+    }
+}
 
-//     Table table(t);
-//     table.sudoku();
-// }
+TEST(WorkStealingPool, nestedTasks)
+{
+    std::atomic<int> counter(0);
+    WorkStealingPool pool(3);
+    std::function<void(int)> spawn = [&](int depth)
+    {
+        ++counter;
+        if (depth < 6)
+            for (int i = 0; i < 3; ++i)
+                pool.submit([&spawn, depth]{ spawn(depth + 1); });
+    };
+    pool.submit([&spawn]{ spawn(0); });
+    pool.wait();
+    EXPECT_EQ(1093, counter.load()); // 1+3+...+3^6
+}
+
+TEST(Board, solveViewInPlace)
+{
+    const std::string& line = uniquePuzzles[1];
+    std::vector<Row> t, e;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    ASSERT_TRUE(Table(t).solve(e));
+
+    Board board;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), board));
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(board[0]) % 64);
+    for (auto engine : {Table::Engine::Propagation,
+                        Table::Engine::DancingLinks})
+    {
+        Board copy = board;
+        Table table(copy.view());
+        table.setEngine(engine);
+        ASSERT_TRUE(table.solve());
+        std::vector<Row> rows;
+        copy.view().toRows(rows);
+        EXPECT_EQ(e, rows);
+    }
+
+    // values out of range and improper sizes in the rows adapter
+    std::vector<Row> result;
+    t[4][5] = 10;
+    EXPECT_THROW(Table(t).solve(result), ImproperAssignmentException);
+    t[4][5] = 0;
+    t.pop_back();
+    EXPECT_THROW(Table(t).solve(result), BadInitTableSizeException);
+}
+
+TEST(Sudoku, trySolveStatus)
+{
+    const std::string& line = uniquePuzzles[0];
+    Board puzzle;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), puzzle));
+    // clues of the same value in one row, and a value out of range
+    Board twice = puzzle, big = puzzle;
+    int col = 0;
+    while (twice[0][col] == 0)
+        ++col;
+    int empty = col + 1;
+    while (twice[0][empty] != 0)
+        ++empty;
+    twice[0][empty] = twice[0][col];
+    big[4][5] = 10;
+    for (auto engine : {Table::Engine::Propagation,
+                        Table::Engine::DancingLinks})
+    {
+        Board board = puzzle;
+        Table table(board.view());
+        table.setEngine(engine);
+        EXPECT_EQ(SolveStatus::Solved, table.trySolve().mStatus);
+        EXPECT_EQ(1, Table(board.view()).countSolutions());
+
+        board = twice;
+        Table conflict(board.view());
+        conflict.setEngine(engine);
+        SolveResult result = conflict.trySolve();
+        EXPECT_EQ(SolveStatus::ImproperClue, result.mStatus);
+        EXPECT_EQ(0, result.mRow);
+        EXPECT_TRUE(result.mCol == col || result.mCol == empty);
+        EXPECT_TRUE(std::equal(board[0], board[0] + 81, twice[0]));
+
+        board = big;
+        Table outOfRange(board.view());
+        outOfRange.setEngine(engine);
+        result = outOfRange.trySolve();
+        EXPECT_EQ(SolveStatus::ImproperClue, result.mStatus);
+        EXPECT_EQ(4, result.mRow);
+        EXPECT_EQ(5, result.mCol);
+
+        // consistent clues, only the search finds there is no solution
+        std::string none =
+            ".7....3...9..2.....2.......9.........84.........8376......"
+            "..8....1........5.94...";
+        ASSERT_TRUE(parsePuzzleLine(none.data(), none.data() + none.size(),
+                                    board));
+        Table noSolution(board.view());
+        noSolution.setEngine(engine);
+        EXPECT_EQ(SolveStatus::NoSolution, noSolution.trySolve().mStatus);
+
+        Board odd(8);
+        Table improper(odd.view());
+        improper.setEngine(engine);
+        EXPECT_EQ(SolveStatus::ImproperSize, improper.trySolve().mStatus);
+    }
+
+    Board board = puzzle;
+    Table limited(board.view());
+    limited.setNodeLimit(1);
+    ASSERT_TRUE(parsePuzzleLine(hardestPuzzle.data(),
+                                hardestPuzzle.data() + hardestPuzzle.size(),
+                                board));
+    EXPECT_EQ(SolveStatus::Aborted, limited.trySolve().mStatus);
+
+    // exceptions of the throwing API keep their message
+    board = big;
+    try
+    {
+        Table(board.view()).solve();
+        FAIL() << "no exception";
+    }
+    catch (ImproperAssignmentException& ex)
+    {
+        EXPECT_STREQ("Impossible number for Cell (4, 5);", ex.what());
+    }
+}
+
+TEST(Sudoku, solveTableTwice)
+{
+    for (const std::string& line : {uniquePuzzles[0], hardestPuzzle})
+    {
+        Board board;
+        ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                    board));
+        std::vector<Row> clues, first;
+        board.view().toRows(clues);
+        BasicTable<3> table(board.view());
+        ASSERT_TRUE(table.solve());
+        first = table.getTable();
+        EXPECT_TRUE(isValidSolution(clues, first)) << line;
+        // the second solve starts from the solved board
+        ASSERT_TRUE(table.solve());
+        EXPECT_EQ(first, table.getTable()) << line;
+        EXPECT_EQ(1, table.countSolutions(2)) << line;
+        EXPECT_TRUE(table.solveWithoutGuessing()) << line;
+    }
+}
+
+TEST(Sudoku, trySolveTwice)
+{
+    // the first rows of hardestPuzzle only, it has many solutions
+    std::string open = hardestPuzzle.substr(0, 27) + std::string(54, '.');
+    for (int thrNum : {1, 2})
+    {
+        for (const std::string& line : {hardestPuzzle, open})
+        {
+            Board board;
+            ASSERT_TRUE(parsePuzzleLine(line.data(),
+                                        line.data() + line.size(), board));
+            std::vector<Row> clues;
+            board.view().toRows(clues);
+            BasicTable<3> table(board.view());
+            EXPECT_TRUE(table.trySolve(thrNum).isSolved()) << line;
+            EXPECT_TRUE(isValidSolution(clues, table.getTable())) << line;
+            // counting from the solved board, then solving again
+            EXPECT_EQ(1, table.countSolutions(2, thrNum)) << line;
+            SolveResult result = table.trySolve(thrNum);
+            EXPECT_TRUE(result.isSolved()) << line;
+            EXPECT_TRUE(isValidSolution(clues, table.getTable())) << line;
+        }
+    }
+    // a board without solution stays so on the second call
+    std::string none =
+        ".7....3...9..2.....2.......9.........84.........8376......"
+        "..8....1........5.94...";
+    Board board;
+    ASSERT_TRUE(parsePuzzleLine(none.data(), none.data() + none.size(),
+                                board));
+    BasicTable<3> noSolution(board.view());
+    EXPECT_EQ(SolveStatus::NoSolution, noSolution.trySolve().mStatus);
+    EXPECT_EQ(0, noSolution.countSolutions(2));
+    EXPECT_EQ(SolveStatus::NoSolution, noSolution.trySolve().mStatus);
+}
+
+// without room for thread stacks the pool can't start, trySolve()
+// searches serially instead of throwing
+TEST(Sudoku, trySolveWithoutThreads)
+{
+    std::string line = uniquePuzzles[0];
+    EXPECT_EXIT(
+    {
+        Board board;
+        parsePuzzleLine(line.data(), line.data() + line.size(), board);
+        long pages = 0;
+        std::FILE* statm = std::fopen("/proc/self/statm", "r");
+        if (!statm || std::fscanf(statm, "%ld", &pages) != 1)
+            std::exit(2);
+        std::fclose(statm);
+        rlimit limit;
+        getrlimit(RLIMIT_AS, &limit);
+        limit.rlim_cur = pages * sysconf(_SC_PAGESIZE) + (4 << 20);
+        setrlimit(RLIMIT_AS, &limit);
+        BasicTable<3> table(board.view());
+        std::exit(table.trySolve(4).isSolved() ? 0 : 1);
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(Sudoku, nodeLimit)
+{
+    const std::string& line = hardestPuzzle;
+    std::vector<Row> t, result;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    Table table(t);
+    table.setNodeLimit(1);
+    EXPECT_FALSE(table.solve(result));
+    EXPECT_TRUE(table.isAborted());
+    table.setNodeLimit(0);
+    EXPECT_TRUE(table.solve(result));
+    EXPECT_FALSE(table.isAborted());
+    EXPECT_TRUE(isValidSolution(t, result));
+
+    Table parallel(t);
+    parallel.setThreadsNum(3);
+    parallel.setNodeLimit(2);
+    EXPECT_FALSE(parallel.solve(result));
+    EXPECT_TRUE(parallel.isAborted());
+}
+
+TEST(Sudoku, timeLimit)
+{
+    // the search needs more nodes than the clock is read after
+    const std::string& line = hardestPuzzle;
+    Board board;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                board));
+    Table table(board.view());
+    table.setTimeLimit(std::chrono::microseconds(1));
+    EXPECT_EQ(SolveStatus::Aborted, table.trySolve().mStatus);
+    EXPECT_TRUE(table.isAborted());
+
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                board));
+    Table parallel(board.view());
+    parallel.setThreadsNum(3);
+    parallel.setTimeLimit(std::chrono::microseconds(1));
+    EXPECT_EQ(SolveStatus::Aborted, parallel.trySolve().mStatus);
+
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                board));
+    Table relaxed(board.view());
+    relaxed.setTimeLimit(std::chrono::seconds(60));
+    relaxed.setNodeLimit(1000000);
+    EXPECT_EQ(SolveStatus::Solved, relaxed.trySolve().mStatus);
+}
+
+TEST(BoundedQueue, pipeline)
+{
+    // two stages: the producer can't get more than capacity ahead
+    BoundedQueue<int> first(4), second(2);
+    std::atomic<long> sum(0);
+    std::vector<std::thread> threads;
+    threads.push_back(std::thread([&first]{
+        for (int i = 1; i <= 1000; ++i)
+            first.push(i);
+        first.close();
+    }));
+    for (int k = 0; k < 3; ++k)
+        threads.push_back(std::thread([&first, &second]{
+            int val;
+            while (first.pop(val))
+                second.push(2*val);
+        }));
+    std::thread consumer([&second, &sum]{
+        int val;
+        while (second.pop(val))
+            sum += val;
+    });
+    for (auto& th : threads)
+        th.join();
+    second.close();
+    consumer.join();
+    EXPECT_EQ(1000*1001, sum);
+
+    int val = 0;
+    BoundedQueue<int> closed(1);
+    EXPECT_TRUE(closed.push(7));
+    EXPECT_FALSE(closed.tryPop(val) && closed.tryPop(val));
+    EXPECT_EQ(7, val);
+    closed.push(8);
+    closed.close();
+    EXPECT_FALSE(closed.push(9));
+    EXPECT_TRUE(closed.pop(val));
+    EXPECT_EQ(8, val);
+    EXPECT_FALSE(closed.pop(val));
+}
+
+int cluesNum(const Board& board)
+{
+    int clues = 0;
+    for (int i = 0; i < board.side(); ++i)
+        for (int j = 0; j < board.side(); ++j)
+            clues += board[i][j] != 0;
+    return clues;
+}
+
+TEST(Generator, uniqueAndReproducible)
+{
+    GeneratorOptions options;
+    options.mSeed = 3;
+    options.mThreadsNum = 3;
+    std::vector<Board> puzzles = PuzzleGenerator(options).generateBatch(0, 12);
+    ASSERT_EQ(12u, puzzles.size());
+    options.mThreadsNum = 1;
+    PuzzleGenerator serial(options);
+    Board single;
+    ASSERT_TRUE(serial.generate(7, single));
+    EXPECT_TRUE(std::equal(single[0], single[0] + 81, puzzles[7][0]));
+    for (auto& puzzle : puzzles)
+    {
+        Board copy = puzzle;
+        EXPECT_EQ(1, Table(copy.view()).countSolutions());
+        EXPECT_GE(cluesNum(puzzle), 17);
+    }
+
+    options.mClues = 30;
+    options.mDifficulty = Difficulty::Easy;
+    for (auto& puzzle : PuzzleGenerator(options).generateBatch(100, 4))
+    {
+        Board copy = puzzle;
+        EXPECT_EQ(30, cluesNum(puzzle));
+        EXPECT_TRUE(Table(copy.view()).solveWithoutGuessing());
+    }
+
+    options.mClues = 0;
+    options.mDifficulty = Difficulty::Hard;
+    for (auto& puzzle : PuzzleGenerator(options).generateBatch(200, 2))
+    {
+        Board copy = puzzle;
+        Table table(copy.view());
+        table.setDeductions(Deductions::all());
+        EXPECT_FALSE(table.solveWithoutGuessing());
+        copy = puzzle;
+        EXPECT_EQ(1, Table(copy.view()).countSolutions());
+    }
+
+    options.mBox = 2;
+    for (auto& puzzle : PuzzleGenerator(options).generateBatch(0, 8))
+    {
+        Board copy = puzzle;
+        EXPECT_EQ(1, Table(copy.view()).countSolutions());
+    }
+    options.mBox = maxBoardBox + 1;
+    EXPECT_THROW(PuzzleGenerator generator(options), BadInitTableSizeException);
+}
+
+TEST(Generator, largeBoxes)
+{
+    // most clues of nearly full boards go as forced ones, values reach
+    // 64 for box 8
+    for (int box = 6; box <= maxBoardBox; ++box)
+    {
+        GeneratorOptions options;
+        options.mBox = box;
+        int side = box * box;
+        options.mClues = side * side * 95 / 100;
+        options.mThreadsNum = 1;
+        Board puzzle;
+        ASSERT_TRUE(PuzzleGenerator(options).generate(0, puzzle)) << box;
+        EXPECT_EQ(side, puzzle.side());
+        EXPECT_EQ(options.mClues, cluesNum(puzzle)) << box;
+        Board copy = puzzle;
+        EXPECT_EQ(1, Table(copy.view()).countSolutions()) << box;
+    }
+}
+
+TEST(PuzzleIO, oneLineFormat)
+{
+    std::string line = hardestPuzzle + "\r";
+    std::vector<Row> t;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(), t));
+    ASSERT_EQ(9u, t.size());
+    EXPECT_EQ(8, t[0][0]);
+    EXPECT_EQ(0, t[0][1]);
+    EXPECT_EQ(4, t[8][6]);
+
+    std::string out;
+    appendPuzzleLine(t, out);
+    EXPECT_EQ(line.substr(0, 81) + "\n", out);
+
+    // 16x16 uses letters for values above 9
+    std::vector<Row> big = patternPuzzle(4, 3);
+    out.clear();
+    appendPuzzleLine(big, out);
+    std::vector<Row> parsed;
+    ASSERT_TRUE(parsePuzzleLine(out.data(), out.data() + out.size() - 1,
+                                parsed));
+    EXPECT_EQ(big, parsed);
+
+    // 64x64 takes lower case letters and '@', '$', '%' above 35
+    big = patternPuzzle(8, 3);
+    out.clear();
+    appendPuzzleLine(big, out);
+    EXPECT_NE(std::string::npos, out.find('%'));
+    EXPECT_NE(std::string::npos, out.find('a'));
+    ASSERT_TRUE(parsePuzzleLine(out.data(), out.data() + out.size() - 1,
+                                parsed));
+    EXPECT_EQ(big, parsed);
+
+    EXPECT_FALSE(parsePuzzleLine(line.data(), line.data() + 80, t));
+    line[5] = '?';
+    EXPECT_FALSE(parsePuzzleLine(line.data(), line.data() + 81, t));
+}
+
+bool sameBoard(BoardView a, BoardView b)
+{
+    return a.side() == b.side()
+        && std::equal(a.data(), a.data() + a.cellsNum(), b.data());
+}
+
+// random symmetry of boards of the given box side
+BoardTransform randomTransform(int box, std::mt19937& rng)
+{
+    BoardTransform transform;
+    transform.mIsTransposed = rng() % 2;
+    std::vector<int> bands(box), stacks(box), inner(box);
+    std::vector<int> digits(box*box);
+    for (int k = 0; k < box; ++k)
+        bands[k] = stacks[k] = inner[k] = k;
+    std::shuffle(bands.begin(), bands.end(), rng);
+    std::shuffle(stacks.begin(), stacks.end(), rng);
+    for (int k = 0; k < box*box; ++k)
+    {
+        if (k % box == 0)
+            std::shuffle(inner.begin(), inner.end(), rng);
+        transform.mRows[k] = bands[k/box]*box + inner[k%box];
+    }
+    for (int k = 0; k < box*box; ++k)
+    {
+        if (k % box == 0)
+            std::shuffle(inner.begin(), inner.end(), rng);
+        transform.mCols[k] = stacks[k/box]*box + inner[k%box];
+        digits[k] = k + 1;
+    }
+    std::shuffle(digits.begin(), digits.end(), rng);
+    transform.mDigits[0] = 0;
+    for (int k = 0; k < box*box; ++k)
+        transform.mDigits[k + 1] = digits[k];
+    return transform;
+}
+
+TEST(Canonical, invariantUnderSymmetries)
+{
+    std::mt19937 rng(7);
+    GeneratorOptions options;
+    for (int box : {2, 3, 4})
+    {
+        options.mBox = box;
+        options.mClues = box == 4 ? 140 : 0;
+        for (auto& puzzle : PuzzleGenerator(options).generateBatch(0, 5))
+        {
+            Board canonical;
+            BoardTransform transform;
+            ASSERT_TRUE(canonicalize(puzzle.view(), canonical, transform));
+            Board image = puzzle;
+            transform.apply(puzzle.view(), image.view());
+            EXPECT_TRUE(sameBoard(image.view(), canonical.view()));
+            Board back = puzzle;
+            transform.applyInverse(image.view(), back.view());
+            EXPECT_TRUE(sameBoard(back.view(), puzzle.view()));
+
+            for (int k = 0; k < 10; ++k)
+            {
+                Board other = puzzle, otherCanonical;
+                randomTransform(box, rng).apply(puzzle.view(), other.view());
+                ASSERT_TRUE(canonicalize(other.view(), otherCanonical,
+                                         transform));
+                EXPECT_TRUE(sameBoard(otherCanonical.view(), canonical.view()));
+            }
+        }
+    }
+    // the empty board has too many equal branches
+    Board empty, canonical;
+    BoardTransform transform;
+    empty.resize(9);
+    EXPECT_FALSE(canonicalize(empty.view(), canonical, transform));
+    options.mBox = 3;
+    options.mClues = 0;
+    Board puzzle = PuzzleGenerator(options).generateBatch(0, 1)[0];
+    EXPECT_FALSE(canonicalize(puzzle.view(), canonical, transform, 8));
+    puzzle[0][0] = 17;
+    EXPECT_FALSE(canonicalize(puzzle.view(), canonical, transform));
+}
+
+TEST(SolutionCache, equivalentPuzzles)
+{
+    std::mt19937 rng(11);
+    SolutionCache cache;
+    const std::string& line = uniquePuzzles[1];
+    Board puzzle;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                puzzle));
+    Board solved = puzzle;
+    Table table(solved.view());
+    table.setCache(&cache);
+    ASSERT_TRUE(table.solve());
+    EXPECT_FALSE(table.isCacheHit());
+    EXPECT_EQ(1u, cache.size());
+
+    for (int k = 0; k < 10; ++k)
+    {
+        BoardTransform transform = randomTransform(3, rng);
+        Board other = puzzle, expected = puzzle;
+        transform.apply(puzzle.view(), other.view());
+        transform.apply(solved.view(), expected.view());
+        Table otherTable(other.view());
+        otherTable.setCache(&cache);
+        EXPECT_TRUE(otherTable.trySolve().isSolved());
+        EXPECT_TRUE(otherTable.isCacheHit());
+        EXPECT_TRUE(sameBoard(other.view(), expected.view()));
+    }
+    EXPECT_EQ(10, cache.getHitsNum());
+    EXPECT_EQ(1, cache.getMissesNum());
+
+    // unsolvable puzzles are not kept
+    const char* bad = ".7....3...9..2.....2.......9.........84........."
+                      "8376........8....1........5.94...";
+    ASSERT_TRUE(parsePuzzleLine(bad, bad + 81, puzzle));
+    Table badTable(puzzle.view());
+    badTable.setCache(&cache);
+    EXPECT_EQ(SolveStatus::NoSolution, badTable.trySolve().mStatus);
+    EXPECT_EQ(1u, cache.size());
+}
+
+TEST(SolutionCache, boundedAndConcurrent)
+{
+    GeneratorOptions options;
+    std::vector<Board> puzzles = PuzzleGenerator(options).generateBatch(0, 40);
+    SolutionCache cache(16, 4);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    for (int thr = 0; thr < 4; ++thr)
+    {
+        threads.push_back(std::thread([&puzzles, &cache, &failed]{
+            for (int round = 0; round < 2; ++round)
+                for (auto& puzzle : puzzles)
+                {
+                    Board copy = puzzle;
+                    Table table(copy.view());
+                    table.setCache(&cache);
+                    std::vector<Row> rows, result;
+                    puzzle.view().toRows(rows);
+                    if (!table.trySolve().isSolved())
+                        ++failed;
+                    copy.view().toRows(result);
+                    if (!isValidSolution(rows, result))
+                        ++failed;
+                }
+        }));
+    }
+    for (auto& th : threads)
+        th.join();
+    EXPECT_EQ(0, failed);
+    EXPECT_LE(cache.size(), 16u);
+    EXPECT_EQ(4*2*40, cache.getHitsNum() + cache.getMissesNum());
+
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    Board copy = puzzles[0];
+    Table table(copy.view());
+    table.setCache(&cache);
+    table.solve();
+    copy = puzzles[0];
+    table.solve();
+    EXPECT_TRUE(table.isCacheHit());
+}
+
+TEST(Lockstep, matchesScalar)
+{
+    // easy puzzles are solved by singles, the rest go to the scalar
+    // solver; more boards than lanes and a board of another side
+    GeneratorOptions options;
+    options.mClues = 30;
+    options.mDifficulty = Difficulty::Easy;
+    std::vector<Board> puzzles = PuzzleGenerator(options).generateBatch(0, 37);
+    // boards singles solve, the easy ones and some of uniquePuzzles
+    std::size_t singlesNum = puzzles.size();
+    Board easy = puzzles[0];
+    for (auto& line : uniquePuzzles)
+    {
+        Board puzzle;
+        ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                    puzzle));
+        puzzles.push_back(puzzle);
+        singlesNum += Table(puzzle.view()).solveWithoutGuessing();
+    }
+    const char* none = ".7....3...9..2.....2.......9.........84........."
+                       "8376........8....1........5.94...";
+    Board puzzle;
+    ASSERT_TRUE(parsePuzzleLine(none, none + 81, puzzle));
+    puzzles.push_back(puzzle);
+    Board twice = puzzles[0], big = puzzles[1];
+    int col = 0;
+    while (twice[2][col] == 0)
+        ++col;
+    int empty = 0;
+    while (twice[2][empty] != 0)
+        ++empty;
+    twice[2][empty] = twice[2][col];
+    big[7][3] = 12;
+    puzzles.insert(puzzles.begin() + 5, twice);
+    puzzles.insert(puzzles.begin() + 20, big);
+    puzzles.insert(puzzles.begin() + 9, Board(16));
+
+    std::vector<Board> expected = puzzles;
+    std::vector<SolveResult> expectedResults;
+    for (auto& board : expected)
+        expectedResults.push_back(Table(board.view()).trySolve());
+    std::vector<BoardView> views;
+    for (auto& board : puzzles)
+        views.push_back(board.view());
+    std::vector<SolveResult> results(puzzles.size());
+    std::size_t solvedNum = trySolveLockstep(views.data(), results.data(),
+                                             views.size());
+    EXPECT_EQ(singlesNum, solvedNum);
+    for (std::size_t i = 0; i < puzzles.size(); ++i)
+    {
+        EXPECT_EQ(expectedResults[i].mStatus, results[i].mStatus) << i;
+        EXPECT_EQ(expectedResults[i].mRow, results[i].mRow) << i;
+        EXPECT_EQ(expectedResults[i].mCol, results[i].mCol) << i;
+        if (results[i].isSolved())
+        {
+            EXPECT_TRUE(sameBoard(puzzles[i].view(), expected[i].view()))
+                << i;
+        }
+    }
+    EXPECT_EQ(SolveStatus::ImproperClue, results[5].mStatus);
+    EXPECT_EQ(SolveStatus::NoSolution, results.back().mStatus);
+
+    // the fallback gets the boards propagation couldn't finish: one
+    // which needs a guess and one with a contradiction
+    const std::string& line = uniquePuzzles[0];
+    Board guess, guessSolved;
+    ASSERT_TRUE(parsePuzzleLine(line.data(), line.data() + line.size(),
+                                guess));
+    guessSolved = guess;
+    ASSERT_TRUE(Table(guessSolved.view()).trySolve().isSolved());
+    puzzles[0] = easy;
+    puzzles[1] = guess;
+    puzzles[2] = twice;
+    std::fill(results.begin(), results.end(), SolveResult());
+    int fallbackNum = 0;
+    solvedNum = trySolveLockstep(views.data(), results.data(), 3,
+                                 [&fallbackNum](BoardView board){
+        ++fallbackNum;
+        return Table(board).trySolve();
+    });
+    EXPECT_EQ(1u, solvedNum);
+    EXPECT_EQ(2, fallbackNum);
+    EXPECT_TRUE(results[0].isSolved());
+    EXPECT_TRUE(sameBoard(puzzles[0].view(), expected[0].view()));
+    EXPECT_TRUE(results[1].isSolved());
+    EXPECT_TRUE(sameBoard(puzzles[1].view(), guessSolved.view()));
+    EXPECT_EQ(SolveStatus::ImproperClue, results[2].mStatus);
+    EXPECT_EQ(expectedResults[5].mRow, results[2].mRow);
+    EXPECT_EQ(expectedResults[5].mCol, results[2].mCol);
+    EXPECT_TRUE(sameBoard(puzzles[2].view(), twice.view()));
+    EXPECT_FALSE(results[3].isSolved());
+}
 
 int main(int argc, char **argv)
 {